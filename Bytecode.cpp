@@ -0,0 +1,233 @@
+#include "Bytecode.h"
+#include <unordered_map>
+#include <algorithm>
+
+namespace {
+
+class ProgramCompiler {
+public:
+    CompiledProgram compile(const vector<Instruction>& instructions) {
+        assign_slots(instructions);
+        program.total_instructions = emit_block(instructions, 0);
+        program.ops.push_back(make_op(OpCode::HALT));
+        program.print_lists = make_shared<const PrintLists>(move(print_lists));
+        return move(program);
+    }
+
+private:
+    // Slots are handed out in program order to every name that DECLARE, READ or SUM
+    // can define. Names that are never defined always read as 0, so they become immediates.
+    void assign_slots(const vector<Instruction>& block) {
+        for (const auto& instruction : block) {
+            if (instruction.type == InstructionType::FOR) {
+                assign_slots(instruction.for_block);
+                continue;
+            }
+            bool defines = instruction.type == InstructionType::DECLARE || instruction.type == InstructionType::READ ||
+                           instruction.type == InstructionType::SUM;
+            if (!defines || instruction.args.empty() || !holds_alternative<string>(instruction.args[0])) continue;
+            const string& name = get<string>(instruction.args[0]);
+            if (slots.count(name) || static_cast<int>(program.slot_names.size()) >= MAX_VARIABLE_SLOTS) continue;
+            slots[name] = static_cast<uint16_t>(program.slot_names.size());
+            program.slot_names.push_back(name);
+        }
+    }
+
+    static BytecodeOp make_op(OpCode code) {
+        return BytecodeOp{code, 0, {0, 0, 0}, 0};
+    }
+
+    uint16_t slot_of(const vector<Value>& args, size_t index) const {
+        if (index >= args.size() || !holds_alternative<string>(args[index])) return NO_SLOT;
+        auto it = slots.find(get<string>(args[index]));
+        return (it == slots.end()) ? NO_SLOT : it->second;
+    }
+
+    void set_operand(BytecodeOp& op, int index, const vector<Value>& args, size_t arg_index) const {
+        uint16_t value = 0;
+        if (arg_index < args.size()) {
+            const Value& arg = args[arg_index];
+            if (holds_alternative<uint16_t>(arg)) value = get<uint16_t>(arg);
+            else if (holds_alternative<int>(arg)) value = static_cast<uint16_t>(get<int>(arg));
+            else if (uint16_t slot = slot_of(args, arg_index); slot != NO_SLOT) {
+                value = slot;
+                op.slot_mask |= 1 << index;
+            }
+        }
+        op.operands[index] = value;
+    }
+
+    static bool address_of(const vector<Value>& args, size_t index, int32_t& address) {
+        if (index >= args.size()) return false;
+        if (holds_alternative<int>(args[index])) address = get<int>(args[index]);
+        else if (holds_alternative<uint16_t>(args[index])) address = get<uint16_t>(args[index]);
+        else return false;
+        return true;
+    }
+
+    static uint16_t immediate_of(const vector<Value>& args, size_t index) {
+        int32_t value = 0;
+        return address_of(args, index, value) ? static_cast<uint16_t>(value) : 0;
+    }
+
+    vector<PrintArg> lower_print_args(const vector<Value>& args) const {
+        vector<PrintArg> lowered;
+        for (size_t i = 0; i < args.size(); ++i) {
+            const Value& arg = args[i];
+            if (holds_alternative<uint16_t>(arg)) lowered.push_back({PrintArg::VALUE, get<uint16_t>(arg), ""});
+            else if (holds_alternative<int>(arg)) lowered.push_back({PrintArg::VALUE, static_cast<uint16_t>(get<int>(arg)), ""});
+            else if (uint16_t slot = slot_of(args, i); slot != NO_SLOT) lowered.push_back({PrintArg::VARIABLE, slot, get<string>(arg)});
+            else lowered.push_back({PrintArg::TEXT, 0, get<string>(arg)});
+        }
+        return lowered;
+    }
+
+    // Returns how many instructions the block executes, counting each FOR body once
+    // per repetition. FOR itself is control flow and is not counted.
+    size_t emit_block(const vector<Instruction>& block, int depth) {
+        size_t executed = 0;
+        for (const auto& instruction : block) {
+            if (instruction.type == InstructionType::FOR) {
+                executed += emit_loop(instruction, depth);
+                continue;
+            }
+            program.ops.push_back(lower(instruction));
+            executed++;
+        }
+        return executed;
+    }
+
+    size_t emit_loop(const Instruction& instruction, int depth) {
+        if (instruction.for_repeats == 0 || instruction.for_block.empty()) return 0;
+        program.max_loop_depth = max(program.max_loop_depth, depth + 1);
+        size_t begin = program.ops.size();
+        BytecodeOp loop_begin = make_op(OpCode::LOOP_BEGIN);
+        loop_begin.operands[0] = instruction.for_repeats;
+        program.ops.push_back(loop_begin);
+        size_t body_count = emit_block(instruction.for_block, depth + 1);
+        if (body_count == 0) {
+            program.ops.resize(begin);
+            return 0;
+        }
+        BytecodeOp loop_end = make_op(OpCode::LOOP_END);
+        loop_end.address = static_cast<int32_t>(begin + 1);
+        program.ops.push_back(loop_end);
+        program.ops[begin].address = static_cast<int32_t>(program.ops.size() - 1);
+        return body_count * instruction.for_repeats;
+    }
+
+    BytecodeOp lower(const Instruction& instruction) {
+        const vector<Value>& args = instruction.args;
+        BytecodeOp op = make_op(OpCode::NOP);
+        switch (instruction.type) {
+            case InstructionType::DECLARE:
+                op.code = OpCode::DECLARE;
+                op.operands[0] = slot_of(args, 0);
+                set_operand(op, 1, args, 1);
+                break;
+            case InstructionType::ADD:
+            case InstructionType::SUBTRACT:
+                // Adding into a name that is never defined does nothing at all.
+                if (slot_of(args, 0) == NO_SLOT) break;
+                op.code = (instruction.type == InstructionType::ADD) ? OpCode::ADD : OpCode::SUBTRACT;
+                op.operands[0] = slot_of(args, 0);
+                set_operand(op, 1, args, 1);
+                set_operand(op, 2, args, 2);
+                break;
+            case InstructionType::READ:
+                if (!address_of(args, 1, op.address)) break;
+                op.code = OpCode::READ;
+                op.operands[0] = slot_of(args, 0);
+                break;
+            case InstructionType::WRITE:
+                if (!address_of(args, 0, op.address)) break;
+                op.code = OpCode::WRITE;
+                set_operand(op, 0, args, 1);
+                break;
+            case InstructionType::SLEEP:
+                if (args.empty()) break;
+                op.code = OpCode::SLEEP;
+                set_operand(op, 0, args, 0);
+                break;
+            case InstructionType::PRINT:
+                op.code = OpCode::PRINT;
+                op.address = static_cast<int32_t>(print_lists.size());
+                print_lists.push_back(lower_print_args(args));
+                break;
+            case InstructionType::MEMSET:
+                if (!address_of(args, 0, op.address) || args.size() < 3) break;
+                op.code = OpCode::MEMSET;
+                set_operand(op, 0, args, 2);
+                op.operands[1] = immediate_of(args, 1);
+                break;
+            case InstructionType::MEMCPY: {
+                int32_t source = 0;
+                if (!address_of(args, 0, op.address) || !address_of(args, 1, source) || args.size() < 3) break;
+                op.code = OpCode::MEMCPY;
+                op.operands[0] = static_cast<uint16_t>(source);
+                op.operands[1] = immediate_of(args, 2);
+                break;
+            }
+            case InstructionType::SUM:
+                if (!address_of(args, 1, op.address) || args.size() < 3) break;
+                op.code = OpCode::SUM;
+                op.operands[0] = slot_of(args, 0);
+                op.operands[1] = immediate_of(args, 2);
+                break;
+            case InstructionType::FOR:
+                break;
+        }
+        return op;
+    }
+
+    CompiledProgram program;
+    PrintLists print_lists;
+    unordered_map<string, uint16_t> slots;
+};
+
+}
+
+CompiledProgram compile_program(const vector<Instruction>& instructions) {
+    return ProgramCompiler().compile(instructions);
+}
+
+// FNV-1a over everything same_program compares.
+uint64_t hash_program(const CompiledProgram& program) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) { hash ^= bytes[i]; hash *= 1099511628211ULL; }
+    };
+    for (const auto& op : program.ops) {
+        mix(&op.code, sizeof(op.code));
+        mix(&op.slot_mask, sizeof(op.slot_mask));
+        mix(op.operands, sizeof(op.operands));
+        mix(&op.address, sizeof(op.address));
+    }
+    for (const auto& args : *program.print_lists) {
+        for (const auto& arg : args) {
+            mix(&arg.kind, sizeof(arg.kind));
+            mix(&arg.value, sizeof(arg.value));
+            mix(arg.text.data(), arg.text.size());
+        }
+        mix("\n", 1);
+    }
+    for (const auto& name : program.slot_names) mix(name.data(), name.size() + 1);
+    return hash;
+}
+
+bool same_program(const CompiledProgram& a, const CompiledProgram& b) {
+    auto same_op = [](const BytecodeOp& x, const BytecodeOp& y) {
+        return x.code == y.code && x.slot_mask == y.slot_mask && x.address == y.address &&
+               equal(begin(x.operands), end(x.operands), begin(y.operands));
+    };
+    auto same_arg = [](const PrintArg& x, const PrintArg& y) {
+        return x.kind == y.kind && x.value == y.value && x.text == y.text;
+    };
+    auto same_list = [&same_arg](const vector<PrintArg>& x, const vector<PrintArg>& y) {
+        return equal(x.begin(), x.end(), y.begin(), y.end(), same_arg);
+    };
+    return a.total_instructions == b.total_instructions && a.slot_names == b.slot_names &&
+           equal(a.ops.begin(), a.ops.end(), b.ops.begin(), b.ops.end(), same_op) &&
+           equal(a.print_lists->begin(), a.print_lists->end(), b.print_lists->begin(), b.print_lists->end(), same_list);
+}
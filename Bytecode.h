@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <memory>
+#include "Instruction.h"
+
+using namespace std;
+
+enum class OpCode : uint8_t {
+    NOP,
+    DECLARE,
+    ADD,
+    SUBTRACT,
+    PRINT,
+    SLEEP,
+    READ,
+    WRITE,
+    LOOP_BEGIN,
+    LOOP_END,
+    HALT,
+    MEMSET,
+    MEMCPY,
+    SUM
+};
+const int NUM_OPCODES = 14;
+
+// Variables live in the first SYMBOL_TABLE_SIZE bytes of process memory, one
+// uint16_t per slot. A name that does not fit gets NO_SLOT.
+const int MAX_VARIABLE_SLOTS = 32;
+const uint16_t NO_SLOT = 0xFFFF;
+
+// One flat instruction. Bit i of slot_mask is set when operands[i] is a variable
+// slot rather than an immediate value. The block operations cover `words` uint16_t
+// values starting at address; their source address and word count are immediates.
+//   DECLARE  slot, value          ADD/SUBTRACT  slot, lhs, rhs
+//   READ     slot, [address]      WRITE         value, [address]
+//   SLEEP    value                PRINT         [address = index into print_lists]
+//   MEMSET   value, words, [address]
+//   MEMCPY   source, words, [address = destination]
+//   SUM      slot, words, [address]
+//   LOOP_BEGIN  repeats, [address = matching LOOP_END]
+//   LOOP_END    [address = first op of the body]
+struct BytecodeOp {
+    OpCode code;
+    uint8_t slot_mask;
+    uint16_t operands[3];
+    int32_t address;
+};
+
+struct PrintArg {
+    enum Kind : uint8_t { TEXT, VALUE, VARIABLE } kind;
+    uint16_t value;  // the immediate, or the slot of a VARIABLE
+    string text;     // printed for TEXT, and for a VARIABLE that is not declared yet
+};
+
+using PrintLists = vector<vector<PrintArg>>;
+
+// A program lowered from an Instruction tree. Ops end with HALT; FOR loops become
+// LOOP_BEGIN/LOOP_END pairs, so the program is never modified while it runs. The
+// print lists are shared separately because log records need them after the ops
+// are gone.
+struct CompiledProgram {
+    vector<BytecodeOp> ops;
+    shared_ptr<const PrintLists> print_lists;
+    vector<string> slot_names;
+    size_t total_instructions = 0;
+    int max_loop_depth = 0;
+};
+
+// An immutable compiled program, shared by every process that runs it.
+using ProgramImage = shared_ptr<const CompiledProgram>;
+
+CompiledProgram compile_program(const vector<Instruction>& instructions);
+uint64_t hash_program(const CompiledProgram& program);
+bool same_program(const CompiledProgram& a, const CompiledProgram& b);
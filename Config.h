@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "ReplacementPolicy.h"
+
+using namespace std;
+
+enum class SchedulingAlgorithm {
+    FCFS,
+    RR,
+    MLFQ,
+    EDF
+};
+
+struct Config {
+    int num_cpu = 1;
+    SchedulingAlgorithm scheduler = SchedulingAlgorithm::FCFS;
+    int quantum_cycles = 10;
+    int batch_process_freq = 100;
+    int min_ins = 100;
+    int max_ins = 500;
+    int delay_per_exec = 0;
+
+    int max_overall_mem = 16384; 
+    int mem_per_frame = 256;    
+    int min_mem_per_proc = 1024;
+    int max_mem_per_proc = 4096;
+    ReplacementKind page_replacement = ReplacementKind::FIFO;
+
+    bool virtual_clock = false;
+
+    bool archive_logs = true;
+    size_t log_capacity = 1024;
+
+    int batch_process_size = 1;
+    int generator_threads = 2;
+    int pager_threads = 2;
+    uint64_t seed = 0;
+
+    int mlfq_levels = 3;
+    vector<int> mlfq_quanta;
+    int mlfq_boost_period = 100;
+};
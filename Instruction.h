@@ -15,7 +15,10 @@ enum class InstructionType {
     SLEEP,
     FOR,
     READ,
-    WRITE
+    WRITE,
+    MEMSET,
+    MEMCPY,
+    SUM
 };
 
 using Value = variant<string, uint16_t, int>;
@@ -0,0 +1,47 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+#include <algorithm>
+
+int LatencyHistogram::bucket_index(uint64_t value) {
+    if (value < SUB_BUCKETS) return static_cast<int>(value);
+    int msb = 0;
+    while ((value >> (msb + 1)) != 0) msb++;
+    int shift = msb - SUB_BUCKET_BITS;
+    int sub_bucket = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    return (shift + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(int index) {
+    if (index < SUB_BUCKETS) return index;
+    int shift = index / SUB_BUCKETS - 1;
+    uint64_t sub_bucket = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket) << shift) + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    buckets[bucket_index(value)]++;
+    total_count++;
+    total_sum += value;
+    uint64_t current_max = max_value.load();
+    while (value > current_max && !max_value.compare_exchange_weak(current_max, value)) {}
+}
+
+uint64_t LatencyHistogram::count() const { return total_count.load(); }
+uint64_t LatencyHistogram::maximum() const { return max_value.load(); }
+
+double LatencyHistogram::mean() const {
+    uint64_t samples = total_count.load();
+    return samples ? static_cast<double>(total_sum.load()) / samples : 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+    uint64_t samples = total_count.load();
+    if (samples == 0) return 0;
+    uint64_t rank = max<uint64_t>(1, static_cast<uint64_t>(ceil(percent / 100.0 * samples)));
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i].load();
+        if (seen >= rank) return min(bucket_upper_bound(i), max_value.load());
+    }
+    return max_value.load();
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+// Log-linear (HDR-style) histogram: values below SUB_BUCKETS are exact, above that
+// each power of two is split into SUB_BUCKETS buckets, bounding the relative error
+// to 1/SUB_BUCKETS. Recording is lock-free.
+class LatencyHistogram {
+public:
+    void record(uint64_t value);
+
+    uint64_t count() const;
+    double mean() const;
+    uint64_t maximum() const;
+    uint64_t percentile(double percent) const;
+
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(int index);
+
+    array<atomic<uint64_t>, NUM_BUCKETS> buckets{};
+    atomic<uint64_t> total_count{0};
+    atomic<uint64_t> total_sum{0};
+    atomic<uint64_t> max_value{0};
+};
@@ -0,0 +1,147 @@
+#include "LogStore.h"
+#include <stdexcept>
+#include <algorithm>
+
+LogStore::LogStore(const string& path) : store_path(path) {
+    store_file.open(store_path, ios::out | ios::trunc | ios::in | ios::binary);
+    if (!store_file.is_open()) {
+        throw runtime_error("Could not open process log store: " + store_path);
+    }
+    writer = thread(&LogStore::writer_loop, this);
+}
+
+LogStore::~LogStore() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        is_stopping = true;
+    }
+    batch_ready.notify_all();
+    space_ready.notify_all();
+    if (writer.joinable()) writer.join();
+    // Processes still running at shutdown have their last records written out too.
+    for (auto& entry : indexes) {
+        if (!entry.second.open_segment.empty()) write_segment(entry.second);
+    }
+    if (store_file.is_open()) store_file.close();
+}
+
+void LogStore::append(int pid, vector<LogRecord>&& records) {
+    if (records.empty()) return;
+    if (records.size() <= MAX_BATCH_RECORDS) {
+        submit({pid, move(records), false});
+        return;
+    }
+    for (size_t first = 0; first < records.size(); first += MAX_BATCH_RECORDS) {
+        size_t last = min(records.size(), first + MAX_BATCH_RECORDS);
+        submit({pid, vector<LogRecord>(records.begin() + first, records.begin() + last), false});
+    }
+}
+
+void LogStore::seal(int pid) {
+    submit({pid, {}, true});
+}
+
+void LogStore::submit(Batch&& batch) {
+    {
+        unique_lock<mutex> lock(queue_mutex);
+        space_ready.wait(lock, [this, &batch] { return queued_records + batch.records.size() <= MAX_QUEUED_RECORDS || is_stopping; });
+        if (is_stopping) return;
+        queued_records += batch.records.size();
+        pending.push_back(move(batch));
+        submitted++;
+    }
+    batch_ready.notify_one();
+}
+
+// Takes every queued batch at once, so the file is flushed once per wakeup rather
+// than once per batch. Their records only stop counting against MAX_QUEUED_RECORDS
+// once written. Anything still queued at shutdown is written before exiting.
+void LogStore::writer_loop() {
+    while (true) {
+        deque<Batch> batches;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            batch_ready.wait(lock, [this] { return !pending.empty() || is_stopping; });
+            if (pending.empty()) return;
+            batches.swap(pending);
+        }
+        size_t written = 0;
+        {
+            lock_guard<mutex> lock(index_mutex);
+            for (auto& batch : batches) {
+                ProcessLogIndex& index = indexes[batch.pid];
+                written += batch.records.size();
+                for (const auto& record : batch.records) {
+                    index.open_segment.push_back(record);
+                    index.total++;
+                    if (index.open_segment.size() == SEGMENT_RECORDS) write_segment(index);
+                }
+                if (batch.seal) {
+                    if (!index.open_segment.empty()) write_segment(index);
+                    vector<LogRecord>().swap(index.open_segment);
+                }
+            }
+            store_file.flush();
+        }
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            completed += batches.size();
+            queued_records -= written;
+        }
+        space_ready.notify_all();
+        batches_done.notify_all();
+    }
+}
+
+// Caller holds index_mutex.
+void LogStore::write_segment(ProcessLogIndex& index) {
+    index.segment_offsets.push_back(end_offset);
+    size_t bytes = index.open_segment.size() * sizeof(LogRecord);
+    store_file.seekp(end_offset, ios::beg);
+    store_file.write(reinterpret_cast<const char*>(index.open_segment.data()), bytes);
+    end_offset += bytes;
+    index.open_segment.clear();
+}
+
+void LogStore::wait_for_writer() {
+    unique_lock<mutex> lock(queue_mutex);
+    uint64_t ticket = submitted;
+    batches_done.wait(lock, [this, ticket] { return completed >= ticket || is_stopping; });
+}
+
+size_t LogStore::count(int pid) {
+    wait_for_writer();
+    lock_guard<mutex> lock(index_mutex);
+    auto it = indexes.find(pid);
+    return (it == indexes.end()) ? 0 : it->second.total;
+}
+
+// Only a sealed process's last segment can be short, so record i lives in segment
+// i / SEGMENT_RECORDS; records not yet written out are still in the open segment.
+vector<LogRecord> LogStore::read(int pid, size_t first, size_t max_records) {
+    wait_for_writer();
+    vector<LogRecord> records;
+    lock_guard<mutex> lock(index_mutex);
+    auto it = indexes.find(pid);
+    if (it == indexes.end() || first >= it->second.total) return records;
+    const ProcessLogIndex& index = it->second;
+    size_t last = min(index.total, first + max_records);
+    records.resize(last - first);
+
+    size_t written = index.total - index.open_segment.size();
+    size_t position = first;
+    while (position < last && position < written) {
+        size_t segment = position / SEGMENT_RECORDS;
+        size_t offset_in_segment = position % SEGMENT_RECORDS;
+        size_t n = min(last, (segment + 1) * SEGMENT_RECORDS) - position;
+        store_file.seekg(index.segment_offsets[segment] + static_cast<long long>(offset_in_segment * sizeof(LogRecord)), ios::beg);
+        if (!store_file.read(reinterpret_cast<char*>(&records[position - first]), n * sizeof(LogRecord))) {
+            store_file.clear();
+            records.resize(position - first);
+            return records;
+        }
+        position += n;
+    }
+    for (; position < last; ++position) records[position - first] = index.open_segment[position - written];
+    return records;
+}
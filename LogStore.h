@@ -0,0 +1,77 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "ProcessLog.h"
+
+using namespace std;
+
+// Append-only file holding every log record of every process. Cores hand records
+// over in per-slice batches and a background writer packs each process's records
+// into fixed-size segments, appending a segment once it fills or the process is
+// sealed. A process's log is then just a list of segment offsets, so any range of
+// it can be read back with a seek per segment instead of loading the whole log.
+class LogStore {
+public:
+    static const size_t SEGMENT_RECORDS = 64;
+    // Records queued or being written, across all batches. Larger appends are split
+    // into batches of at most MAX_BATCH_RECORDS so each one fits under the limit.
+    static const size_t MAX_QUEUED_RECORDS = 65536;
+    static const size_t MAX_BATCH_RECORDS = SEGMENT_RECORDS * 16;
+
+    explicit LogStore(const string& path);
+    ~LogStore();
+
+    // Queues records for the writer. Blocks while MAX_QUEUED_RECORDS are not yet
+    // written, so records are never dropped and queued ones stay bounded.
+    void append(int pid, vector<LogRecord>&& records);
+    // Writes out the process's partially filled segment when it retires. Nothing may
+    // be appended for the process afterwards.
+    void seal(int pid);
+
+    // Both wait for the writer to take in everything queued before the call.
+    size_t count(int pid);
+    vector<LogRecord> read(int pid, size_t first, size_t max_records);
+
+private:
+    struct Batch {
+        int pid;
+        vector<LogRecord> records;
+        bool seal;
+    };
+    struct ProcessLogIndex {
+        vector<long long> segment_offsets;
+        vector<LogRecord> open_segment;
+        size_t total = 0;
+    };
+
+    void submit(Batch&& batch);
+    void writer_loop();
+    void write_segment(ProcessLogIndex& index);
+    void wait_for_writer();
+
+    string store_path;
+    fstream store_file;
+    long long end_offset = 0;
+
+    deque<Batch> pending;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    size_t queued_records = 0;
+    bool is_stopping = false;
+    mutex queue_mutex;
+    condition_variable batch_ready;
+    condition_variable space_ready;
+    condition_variable batches_done;
+
+    unordered_map<int, ProcessLogIndex> indexes;
+    mutex index_mutex;
+
+    thread writer;
+};
@@ -3,12 +3,66 @@
 #include <stdexcept>
 #include <cmath>
 #include <algorithm>
+#include <thread>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CSOPESY_SSE2
+#endif
 
-MemoryManager::MemoryManager(int total_mem_size, int frame_sz)
-    : total_memory_size(total_mem_size), frame_size(frame_sz) {
+namespace {
+
+int lowest_set_bit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+}
+
+FrameBitmap::FrameBitmap(int num_frames)
+    : words((num_frames + 63) / 64, ~0ULL), summary((words.size() + 63) / 64, ~0ULL) {
+    if (num_frames % 64) words.back() = (1ULL << (num_frames % 64)) - 1;
+    if (words.size() % 64) summary.back() = (1ULL << (words.size() % 64)) - 1;
+}
+
+void FrameBitmap::set_free(int frame) {
+    int word = frame / 64;
+    words[word] |= 1ULL << (frame % 64);
+    summary[word / 64] |= 1ULL << (word % 64);
+}
+
+void FrameBitmap::set_used(int frame) {
+    int word = frame / 64;
+    words[word] &= ~(1ULL << (frame % 64));
+    if (words[word] == 0) summary[word / 64] &= ~(1ULL << (word % 64));
+}
+
+// One summary word covers 4096 frames, so the scan is a single step for any
+// realistic memory size.
+int FrameBitmap::lowest_free() const {
+    for (size_t i = 0; i < summary.size(); ++i) {
+        if (summary[i] == 0) continue;
+        int word = static_cast<int>(i * 64) + lowest_set_bit(summary[i]);
+        return word * 64 + lowest_set_bit(words[word]);
+    }
+    return -1;
+}
+
+MemoryManager::MemoryManager(int total_mem_size, int frame_sz, ReplacementKind replacement)
+    : total_memory_size(total_mem_size), frame_size(frame_sz), free_frames(frame_sz > 0 ? total_mem_size / frame_sz : 0) {
     if (frame_size <= 0) throw std::invalid_argument("Frame size must be positive.");
     num_frames = total_memory_size / frame_size;
+    policy = make_replacement_policy(replacement, num_frames);
     physical_frames.resize(num_frames);
+    frame_guards = std::vector<FrameGuard>(num_frames);
     physical_memory.resize(total_memory_size, 0);
 
     backing_store.open(backing_store_file, std::ios::out | std::ios::trunc | std::ios::in | std::ios::binary);
@@ -23,29 +77,85 @@ MemoryManager::~MemoryManager() {
 
 bool MemoryManager::create_virtual_memory_for_process(std::shared_ptr<Process> process) {
     std::lock_guard<std::mutex> lock(memory_mutex);
-    if (page_tables.count(process->id)) return false;
+    if (process->memory_handle != -1) return false;
     
     int num_pages = static_cast<int>(ceil(static_cast<double>(process->memory_size) / frame_size));
-    page_tables[process->id] = std::vector<PageTableEntry>(num_pages);
+    int handle;
+    if (!free_handles.empty()) {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    } else {
+        handle = static_cast<int>(page_tables.size());
+        page_tables.emplace_back();
+    }
+    page_tables[handle].entries = std::vector<PageTableEntry>(num_pages);
+    page_tables[handle].backing_store_locations.assign(num_pages, -1);
+    process->memory_handle = handle;
     return true;
 }
 
 void MemoryManager::release_memory_for_process(std::shared_ptr<Process> process) {
     std::lock_guard<std::mutex> lock(memory_mutex);
-    if (!page_tables.count(process->id)) return;
-
-    for (const auto& pte : page_tables.at(process->id)) {
-        if (pte.present) {
-            physical_frames[pte.frame_number].is_free = true;
-            physical_frames[pte.frame_number].process_id = -1;
-            physical_frames[pte.frame_number].page_number = -1;
-            fifo_queue.remove(pte.frame_number);
+    int handle = process->memory_handle;
+    if (handle == -1) return;
+
+    PageTable& table = page_tables[handle];
+    for (const auto& pte : table.entries) {
+        if (pte.is_present()) {
+            int frame_number = pte.frame_number();
+            shoot_down_frame(frame_number);
+            used_frames--;
+            if (pte.is_accessed()) active_pages--;
+            dequeue_frame(frame_number);
+            physical_frames[frame_number].owner_handle = -1;
+            physical_frames[frame_number].page_number = -1;
+            free_frames.set_free(frame_number);
         }
     }
-    page_tables.erase(process->id);
+    std::vector<PageTableEntry>().swap(table.entries);
+    std::vector<long long>().swap(table.backing_store_locations);
+    free_handles.push_back(handle);
+    process->memory_handle = -1;
+}
+
+bool MemoryManager::pin_frame(const TlbEntry& entry) {
+    FrameGuard& guard = frame_guards[entry.frame];
+    guard.pins.fetch_add(1);
+    if (guard.generation.load() == entry.generation) return true;
+    guard.pins.fetch_sub(1, std::memory_order_release);
+    return false;
+}
+
+void MemoryManager::unpin_frame(int frame_number) {
+    frame_guards[frame_number].pins.fetch_sub(1, std::memory_order_release);
 }
 
-std::optional<uint16_t> MemoryManager::read_memory(std::shared_ptr<Process> process, int virtual_address) {
+// Invalidates every TLB entry for the frame, then waits out any access already in flight.
+void MemoryManager::shoot_down_frame(int frame_number) {
+    FrameGuard& guard = frame_guards[frame_number];
+    guard.generation.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_release);
+    while (guard.pins.load(std::memory_order_acquire) != 0) std::this_thread::yield();
+}
+
+// Caller holds memory_mutex. Returns nullptr for a page outside the process's table.
+PageTableEntry* MemoryManager::find_pte(const Process& process, int page_number) {
+    int handle = process.memory_handle;
+    if (handle < 0 || page_number < 0) return nullptr;
+    std::vector<PageTableEntry>& entries = page_tables[handle].entries;
+    return (page_number < static_cast<int>(entries.size())) ? &entries[page_number] : nullptr;
+}
+
+// Called under memory_mutex once the page is known present and accessed.
+void MemoryManager::fill_tlb(Process& process, int page_number, PageTableEntry& pte) {
+    TlbEntry& entry = process.tlb->slot(page_number);
+    entry.page = page_number;
+    entry.frame = pte.frame_number();
+    entry.generation = frame_guards[entry.frame].generation.load();
+    entry.pte = &pte;
+}
+
+std::optional<uint16_t> MemoryManager::read_memory(const std::shared_ptr<Process>& process, int virtual_address) {
     if (virtual_address < 0 || virtual_address + sizeof(uint16_t) > process->memory_size) {
         process->set_memory_violation(virtual_address);
         return std::nullopt;
@@ -53,28 +163,48 @@ std::optional<uint16_t> MemoryManager::read_memory(std::shared_ptr<Process> proc
 
     int page_number = virtual_address / frame_size;
     int offset = virtual_address % frame_size;
+
+    // Reads need no pin: a value read while the frame was being shot down is
+    // caught by the second generation check and re-read on the slow path.
+    const TlbEntry& entry = process->tlb->slot(page_number);
+    if (entry.page == page_number) {
+        const FrameGuard& guard = frame_guards[entry.frame];
+        if (guard.generation.load(std::memory_order_acquire) == entry.generation) {
+            uint16_t value = *reinterpret_cast<const uint16_t*>(&physical_memory[entry.frame * frame_size + offset]);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (guard.generation.load(std::memory_order_relaxed) == entry.generation) {
+                process->tlb->hits++;
+                return value;
+            }
+        }
+    }
+    process->tlb->misses++;
     
     std::lock_guard<std::mutex> lock(memory_mutex);
     
-    if (page_tables.find(process->id) == page_tables.end() || page_number >= page_tables.at(process->id).size()) {
+    PageTableEntry* pte = find_pte(*process, page_number);
+    if (!pte) {
          process->set_memory_violation(virtual_address);
          return std::nullopt;
     }
 
-    PageTableEntry& pte = page_tables.at(process->id).at(page_number);
-    if (!pte.present) {
+    uint32_t word = pte->load();
+    if (!(word & PageTableEntry::PRESENT)) {
         return std::nullopt; 
     }
     
-    pte.accessed = true;
-
+    if (!(word & PageTableEntry::ACCESSED)) {
+        pte->set(PageTableEntry::ACCESSED);
+        active_pages++;
+    }
+    fill_tlb(*process, page_number, *pte);
 
-    int frame_address = pte.frame_number * frame_size;
+    int frame_address = static_cast<int>(word & PageTableEntry::FRAME_MASK) * frame_size;
     uint16_t value = *reinterpret_cast<uint16_t*>(&physical_memory[frame_address + offset]);
     return value;
 }
 
-bool MemoryManager::write_memory(std::shared_ptr<Process> process, int virtual_address, uint16_t value) {
+bool MemoryManager::write_memory(const std::shared_ptr<Process>& process, int virtual_address, uint16_t value) {
     if (virtual_address < 0 || virtual_address + sizeof(uint16_t) > process->memory_size) {
         process->set_memory_violation(virtual_address);
         return false;
@@ -83,128 +213,313 @@ bool MemoryManager::write_memory(std::shared_ptr<Process> process, int virtual_a
     int page_number = virtual_address / frame_size;
     int offset = virtual_address % frame_size;
 
+    const TlbEntry& entry = process->tlb->slot(page_number);
+    if (entry.page == page_number && pin_frame(entry)) {
+        *reinterpret_cast<uint16_t*>(&physical_memory[entry.frame * frame_size + offset]) = value;
+        entry.pte->set(PageTableEntry::DIRTY);
+        unpin_frame(entry.frame);
+        process->tlb->hits++;
+        return true;
+    }
+    process->tlb->misses++;
+
     std::lock_guard<std::mutex> lock(memory_mutex);
 
-    if (page_tables.find(process->id) == page_tables.end() || page_number >= page_tables.at(process->id).size()) {
+    PageTableEntry* pte = find_pte(*process, page_number);
+    if (!pte) {
          process->set_memory_violation(virtual_address);
          return false;
     }
 
-    PageTableEntry& pte = page_tables.at(process->id).at(page_number);
-    if (!pte.present) {
+    uint32_t word = pte->load();
+    if (!(word & PageTableEntry::PRESENT)) {
         return false; 
     }
 
-    pte.accessed = true;
+    if (!(word & PageTableEntry::ACCESSED)) active_pages++;
+    pte->set(PageTableEntry::ACCESSED | PageTableEntry::DIRTY);
+    fill_tlb(*process, page_number, *pte);
 
-    int frame_address = pte.frame_number * frame_size;
+    int frame_address = static_cast<int>(word & PageTableEntry::FRAME_MASK) * frame_size;
     *reinterpret_cast<uint16_t*>(&physical_memory[frame_address + offset]) = value;
-    pte.dirty = true;
     return true;
 }
 
+namespace {
+
+// Byte i of a block belongs to word i / 2, low byte first. A chunk that starts on a
+// high byte (odd) is one a page boundary split in the middle of a word.
+void fill_bytes(uint8_t* out, int n, uint16_t value, bool odd) {
+    if (odd && n > 0) { *out++ = static_cast<uint8_t>(value >> 8); n--; }
+#ifdef CSOPESY_SSE2
+    const __m128i pattern = _mm_set1_epi16(static_cast<short>(value));
+    for (; n >= 16; n -= 16, out += 16) _mm_storeu_si128(reinterpret_cast<__m128i*>(out), pattern);
+#endif
+    for (; n >= 2; n -= 2, out += 2) std::memcpy(out, &value, sizeof(value));
+    if (n > 0) *out = static_cast<uint8_t>(value & 0xFF);
+}
+
+// Sums the chunk's words, with the bytes at even and odd positions totalled
+// separately so a word split across pages still counts its high byte as such.
+uint64_t sum_bytes(const uint8_t* in, int n, bool odd) {
+    uint64_t even_total = 0, odd_total = 0;
+    int i = 0;
+#ifdef CSOPESY_SSE2
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i even_acc = zero, odd_acc = zero;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        even_acc = _mm_add_epi64(even_acc, _mm_sad_epu8(_mm_and_si128(v, low_bytes), zero));
+        odd_acc = _mm_add_epi64(odd_acc, _mm_sad_epu8(_mm_srli_epi16(v, 8), zero));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), even_acc);
+    even_total = lanes[0] + lanes[1];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), odd_acc);
+    odd_total = lanes[0] + lanes[1];
+#endif
+    for (; i < n; ++i) ((i % 2 == 0) ? even_total : odd_total) += in[i];
+    return odd ? (even_total << 8) + odd_total : even_total + (odd_total << 8);
+}
+
+}
+
+bool MemoryManager::check_block(Process& process, int address, int bytes) {
+    if (address >= 0 && bytes >= 0 && address + bytes <= process.memory_size) return true;
+    process.set_memory_violation(address < 0 ? address : std::max(address, process.memory_size));
+    return false;
+}
+
+// Caller holds memory_mutex. Returns the page's bytes, or nullptr if it is not resident.
+uint8_t* MemoryManager::resident_page(Process& process, int page_number, bool write) {
+    PageTableEntry* pte = find_pte(process, page_number);
+    uint32_t word = pte ? pte->load() : 0;
+    if (!(word & PageTableEntry::PRESENT)) return nullptr;
+    if (!(word & PageTableEntry::ACCESSED)) active_pages++;
+    pte->set(write ? PageTableEntry::ACCESSED | PageTableEntry::DIRTY : PageTableEntry::ACCESSED);
+    return &physical_memory[static_cast<int>(word & PageTableEntry::FRAME_MASK) * frame_size];
+}
+
+BlockStatus MemoryManager::fill_memory(const std::shared_ptr<Process>& process, int address, int bytes, uint16_t value, BlockProgress& progress, BlockFault& fault) {
+    if (!check_block(*process, address, bytes)) return BlockStatus::VIOLATION;
+    while (progress.done < bytes) {
+        int position = address + progress.done;
+        int offset = position % frame_size;
+        int chunk = std::min(bytes - progress.done, frame_size - offset);
+        std::lock_guard<std::mutex> lock(memory_mutex);
+        uint8_t* page = resident_page(*process, position / frame_size, true);
+        if (!page) {
+            fault = {position, bytes - progress.done};
+            return BlockStatus::PAGE_FAULT;
+        }
+        fill_bytes(page + offset, chunk, value, progress.done % 2 != 0);
+        progress.done += chunk;
+    }
+    return BlockStatus::DONE;
+}
+
+// Chunks end at whichever of the two pages ends first. When the destination overlaps
+// the end of the source the copy runs backwards, like memmove, so every byte is read
+// before it is overwritten.
+BlockStatus MemoryManager::copy_memory(const std::shared_ptr<Process>& process, int destination, int source, int bytes, BlockProgress& progress, BlockFault& fault) {
+    if (!check_block(*process, destination, bytes) || !check_block(*process, source, bytes)) return BlockStatus::VIOLATION;
+    bool backwards = destination > source && destination < source + bytes;
+    while (progress.done < bytes) {
+        int remaining = bytes - progress.done;
+        int from, to, chunk;
+        if (!backwards) {
+            from = source + progress.done;
+            to = destination + progress.done;
+            chunk = std::min({remaining, frame_size - from % frame_size, frame_size - to % frame_size});
+        } else {
+            chunk = std::min({remaining, (source + remaining - 1) % frame_size + 1, (destination + remaining - 1) % frame_size + 1});
+            from = source + remaining - chunk;
+            to = destination + remaining - chunk;
+        }
+        std::lock_guard<std::mutex> lock(memory_mutex);
+        uint8_t* from_page = resident_page(*process, from / frame_size, false);
+        if (!from_page) {
+            fault = backwards ? BlockFault{from, chunk} : BlockFault{from, remaining};
+            return BlockStatus::PAGE_FAULT;
+        }
+        uint8_t* to_page = resident_page(*process, to / frame_size, true);
+        if (!to_page) {
+            fault = backwards ? BlockFault{to, chunk} : BlockFault{to, remaining};
+            return BlockStatus::PAGE_FAULT;
+        }
+        std::memmove(to_page + to % frame_size, from_page + from % frame_size, chunk);
+        progress.done += chunk;
+    }
+    return BlockStatus::DONE;
+}
+
+BlockStatus MemoryManager::sum_memory(const std::shared_ptr<Process>& process, int address, int bytes, BlockProgress& progress, BlockFault& fault) {
+    if (!check_block(*process, address, bytes)) return BlockStatus::VIOLATION;
+    while (progress.done < bytes) {
+        int position = address + progress.done;
+        int offset = position % frame_size;
+        int chunk = std::min(bytes - progress.done, frame_size - offset);
+        std::lock_guard<std::mutex> lock(memory_mutex);
+        const uint8_t* page = resident_page(*process, position / frame_size, false);
+        if (!page) {
+            fault = {position, bytes - progress.done};
+            return BlockStatus::PAGE_FAULT;
+        }
+        progress.sum += sum_bytes(page + offset, chunk, progress.done % 2 != 0);
+        progress.done += chunk;
+    }
+    return BlockStatus::DONE;
+}
+
 bool MemoryManager::handle_page_fault(std::shared_ptr<Process> process, int page_number) {
     std::lock_guard<std::mutex> lock(memory_mutex);
     
-    if (page_tables.find(process->id) == page_tables.end() || page_number >= page_tables.at(process->id).size()) {
+    PageTableEntry* pte = find_pte(*process, page_number);
+    if (!pte) {
         process->set_memory_violation(page_number * frame_size); 
         return false;
     }
+    if (pte->is_present()) return true;
     
-    stats.page_ins++;
+    page_ins++;
     
-    std::optional<int> free_frame_opt = find_free_frame();
-    int frame_to_use;
-
-    if (free_frame_opt) {
-        frame_to_use = *free_frame_opt;
-    } else {
-        frame_to_use = evict_page_fifo();
-    }
+    int frame_to_use = free_frames.lowest_free();
+    if (frame_to_use == -1) frame_to_use = evict_page();
     
     load_page_into_frame(frame_to_use, process, page_number);
     return true;
 }
 
-std::optional<int> MemoryManager::find_free_frame() {
-    for (int i = 0; i < num_frames; ++i) {
-        if (physical_frames[i].is_free) return i;
+void MemoryManager::enqueue_frame(int frame_number) {
+    Frame& frame = physical_frames[frame_number];
+    frame.prev = queue_tail;
+    frame.next = -1;
+    if (queue_tail != -1) physical_frames[queue_tail].next = frame_number;
+    else queue_head = frame_number;
+    queue_tail = frame_number;
+}
+
+void MemoryManager::dequeue_frame(int frame_number) {
+    Frame& frame = physical_frames[frame_number];
+    if (frame.prev != -1) physical_frames[frame.prev].next = frame.next;
+    else queue_head = frame.next;
+    if (frame.next != -1) physical_frames[frame.next].prev = frame.prev;
+    else queue_tail = frame.prev;
+    frame.prev = frame.next = -1;
+}
+
+PageTableEntry& MemoryManager::frame_pte(int frame_number) {
+    const Frame& frame = physical_frames[frame_number];
+    return page_tables[frame.owner_handle].entries[frame.page_number];
+}
+
+// Caller holds memory_mutex and has shot the frame down.
+void MemoryManager::write_frame(int frame_number) {
+    const Frame& frame = physical_frames[frame_number];
+    long long& location = page_tables[frame.owner_handle].backing_store_locations[frame.page_number];
+    if (location == -1) {
+        location = next_backing_store_pos;
+        next_backing_store_pos += frame_size;
     }
-    return std::nullopt;
+    backing_store.seekp(location, std::ios::beg);
+    backing_store.write(reinterpret_cast<char*>(&physical_memory[frame_number * frame_size]), frame_size);
+    backing_store.flush();
+    page_writes++;
 }
 
-int MemoryManager::evict_page_fifo() {
-    if (fifo_queue.empty()) {
-        throw std::runtime_error("FIFO queue is empty, cannot evict a page.");
+int MemoryManager::evict_page() {
+    if (queue_head == -1) {
+        throw std::runtime_error("Replacement queue is empty, cannot evict a page.");
     }
     
-    stats.page_outs++;
-    int frame_to_evict = fifo_queue.front();
-    fifo_queue.pop_front();
-
-    Frame& frame = physical_frames[frame_to_evict];
-    PageTableEntry& pte = page_tables.at(frame.process_id).at(frame.page_number);
+    page_outs++;
+    int frame_to_evict = policy->choose_victim(resident);
+    dequeue_frame(frame_to_evict);
 
-    if (pte.dirty) {
-        if (pte.backing_store_location == -1) {
-            pte.backing_store_location = next_backing_store_pos;
-            next_backing_store_pos += frame_size;
-        }
-        backing_store.seekp(pte.backing_store_location, std::ios::beg);
-        backing_store.write(reinterpret_cast<char*>(&physical_memory[frame_to_evict * frame_size]), frame_size);
-        backing_store.flush();
-    }
+    shoot_down_frame(frame_to_evict);
+    PageTableEntry& pte = frame_pte(frame_to_evict);
+    if (pte.is_dirty()) write_frame(frame_to_evict);
     
-    pte.present = false;
-    pte.dirty = false;
-    frame.is_free = true;
+    if (pte.is_accessed()) active_pages--;
+    pte.unmap();
+    used_frames--;
     
     return frame_to_evict;
 }
 
 void MemoryManager::load_page_into_frame(int frame_number, std::shared_ptr<Process> process, int page_number) {
     Frame& frame = physical_frames[frame_number];
-    PageTableEntry& pte = page_tables.at(process->id).at(page_number);
+    PageTable& table = page_tables[process->memory_handle];
+    PageTableEntry& pte = table.entries[page_number];
 
-    if (pte.backing_store_location != -1) {
-        backing_store.seekg(pte.backing_store_location, std::ios::beg);
+    long long location = table.backing_store_locations[page_number];
+    if (location != -1) {
+        backing_store.seekg(location, std::ios::beg);
         backing_store.read(reinterpret_cast<char*>(&physical_memory[frame_number * frame_size]), frame_size);
     } else {
         std::fill(physical_memory.begin() + (frame_number * frame_size),
                   physical_memory.begin() + ((frame_number + 1) * frame_size), 0);
     }
 
-    frame.is_free = false;
-    frame.process_id = process->id;
+    free_frames.set_used(frame_number);
+    frame.owner_handle = process->memory_handle;
     frame.page_number = page_number;
     
-    pte.present = true;
-    pte.frame_number = frame_number;
+    pte.map(frame_number);
+    used_frames++;
+    active_pages++;
     
-    fifo_queue.push_back(frame_number);
+    enqueue_frame(frame_number);
+    policy->on_load(resident, frame_number);
 }
 
 int MemoryManager::get_total_memory() const { return total_memory_size; }
-int MemoryManager::get_used_memory() const {
-    std::lock_guard<std::mutex> lock(memory_mutex);
-    int used_frames = 0;
-    for (const auto& frame : physical_frames) {
-        if (!frame.is_free) used_frames++;
-    }
-    return used_frames * frame_size;
-}
+int MemoryManager::get_num_frames() const { return num_frames; }
+int MemoryManager::get_used_memory() const { return used_frames.load() * frame_size; }
 int MemoryManager::get_free_memory() const { return total_memory_size - get_used_memory(); }
-const PagingStats& MemoryManager::get_paging_stats() const { return stats; }
+int MemoryManager::get_active_memory() const { return active_pages.load() * frame_size; }
 
-int MemoryManager::get_active_memory() const {
-    std::lock_guard<std::mutex> lock(memory_mutex);
-    int active_memory_size = 0;
-    for (const auto& pair : page_tables) {
-        for (const auto& pte : pair.second) {
-            if (pte.present && pte.accessed) {
-                active_memory_size += frame_size;
-            }
-        }
-    }
-    return active_memory_size;
-}
\ No newline at end of file
+MemorySnapshot MemoryManager::snapshot() const {
+    MemorySnapshot snapshot;
+    snapshot.total_memory = total_memory_size;
+    snapshot.used_memory = get_used_memory();
+    snapshot.active_memory = get_active_memory();
+    snapshot.free_memory = total_memory_size - snapshot.used_memory;
+    snapshot.page_ins = page_ins.load();
+    snapshot.page_outs = page_outs.load();
+    snapshot.page_writes = page_writes.load();
+    snapshot.replacement_policy = policy->name();
+    return snapshot;
+}
+
+int ResidentFrames::size() const { return memory.used_frames.load(); }
+int ResidentFrames::oldest() const { return memory.queue_head; }
+int ResidentFrames::next(int frame) const { return memory.physical_frames[frame].next; }
+
+void ResidentFrames::requeue(int frame) {
+    if (frame == memory.queue_tail) return;
+    memory.dequeue_frame(frame);
+    memory.enqueue_frame(frame);
+}
+
+// The frame's data is not touched, so accesses already in flight need not drain.
+bool ResidentFrames::test_and_clear_referenced(int frame) {
+    if (!memory.frame_pte(frame).clear(PageTableEntry::ACCESSED)) return false;
+    memory.active_pages--;
+    memory.frame_guards[frame].generation.fetch_add(1);
+    return true;
+}
+
+bool ResidentFrames::is_referenced(int frame) const { return memory.frame_pte(frame).is_accessed(); }
+bool ResidentFrames::is_dirty(int frame) const { return memory.frame_pte(frame).is_dirty(); }
+
+// The shoot-down stops TLB writes, so nothing can dirty the frame between the
+// write and clearing DIRTY.
+void ResidentFrames::write_back(int frame) {
+    memory.shoot_down_frame(frame);
+    memory.write_frame(frame);
+    memory.frame_pte(frame).clear(PageTableEntry::DIRTY);
+}
+
+uint64_t ResidentFrames::now() const { return memory.page_ins.load(); }
@@ -4,55 +4,148 @@
 #include <string>
 #include <mutex>
 #include <memory>
-#include <list>
 #include <optional>
-#include <map>
 #include <fstream>
 #include <atomic>
 #include <cstdint>
 #include "Process.h"
+#include "ReplacementPolicy.h"
 
+// One page table entry packed into a word: the frame number in the low bits and
+// the status flags above it, so a translation is a single load. Flags are changed
+// under memory_mutex, except DIRTY, which the TLB write path sets on its own.
 struct PageTableEntry {
-    bool present = false;
-    bool dirty = false;
-    bool accessed = false; 
-    int frame_number = -1;
-    long long backing_store_location = -1;
+    static const uint32_t PRESENT = 1u << 31;
+    static const uint32_t DIRTY = 1u << 30;
+    static const uint32_t ACCESSED = 1u << 29;
+    static const uint32_t FRAME_MASK = ACCESSED - 1;
+
+    std::atomic<uint32_t> word{0};
+
+    uint32_t load() const { return word.load(std::memory_order_relaxed); }
+    bool is_present() const { return load() & PRESENT; }
+    bool is_dirty() const { return load() & DIRTY; }
+    bool is_accessed() const { return load() & ACCESSED; }
+    int frame_number() const { return static_cast<int>(load() & FRAME_MASK); }
+
+    // Only writes the word when a flag is actually missing.
+    void set(uint32_t flags) {
+        if ((load() & flags) != flags) word.fetch_or(flags, std::memory_order_relaxed);
+    }
+    // The faulting access is a loaded page's first reference, so a replacement
+    // policy does not evict it before the process gets to retry.
+    void map(int frame) { word.store(PRESENT | ACCESSED | static_cast<uint32_t>(frame), std::memory_order_relaxed); }
+    void unmap() { word.store(0, std::memory_order_relaxed); }
+    // Returns which of the flags were set.
+    uint32_t clear(uint32_t flags) {
+        if (!(load() & flags)) return 0;
+        return word.fetch_and(~flags, std::memory_order_relaxed) & flags;
+    }
 };
 
+// A process's page table. Tables live in one array indexed by the process's
+// memory_handle; a released slot is handed to the next process created.
+struct PageTable {
+    std::vector<PageTableEntry> entries;
+    std::vector<long long> backing_store_locations;
+};
+
+// prev and next link the resident frames into the replacement queue, in load
+// order unless the policy requeues them, so a frame leaves the queue in O(1)
+// wherever it is.
 struct Frame {
-    bool is_free = true;
-    int process_id = -1;
+    int owner_handle = -1;
     int page_number = -1;
+    int prev = -1;
+    int next = -1;
 };
 
-struct PagingStats {
-    std::atomic<uint64_t> page_ins{0};
-    std::atomic<uint64_t> page_outs{0};
+// Free frames as a two-level bitmap: bit f of words is set while frame f is free,
+// and bit w of summary while words[w] has any bit set, so the lowest free frame is
+// found with two find-first-set steps.
+class FrameBitmap {
+public:
+    explicit FrameBitmap(int num_frames);
+
+    void set_free(int frame);
+    void set_used(int frame);
+    int lowest_free() const;  // -1 when every frame is in use
+
+private:
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> summary;
+};
+
+// Lets cores access a frame through their TLB without memory_mutex. Eviction and
+// release bump the generation, which invalidates every TLB entry for the frame,
+// then wait for pins to drain before touching it. Writers pin the frame and check
+// the generation their entry recorded; readers check it before and after reading.
+struct alignas(64) FrameGuard {
+    std::atomic<uint32_t> generation{0};
+    std::atomic<int> pins{0};
+};
+
+enum class BlockStatus { DONE, PAGE_FAULT, VIOLATION };
+
+// The range a block operation needs loaded before it can continue.
+struct BlockFault {
+    int address = -1;
+    int length = 0;
+};
+
+struct MemorySnapshot {
+    int total_memory = 0;
+    int used_memory = 0;
+    int active_memory = 0;
+    int free_memory = 0;
+    uint64_t page_ins = 0;
+    uint64_t page_outs = 0;
+    uint64_t page_writes = 0;
+    const char* replacement_policy = "";
 };
 
 class MemoryManager {
 public:
-    MemoryManager(int total_mem_size, int frame_sz);
+    MemoryManager(int total_mem_size, int frame_sz, ReplacementKind replacement = ReplacementKind::FIFO);
     ~MemoryManager();
 
     bool create_virtual_memory_for_process(std::shared_ptr<Process> process);
     void release_memory_for_process(std::shared_ptr<Process> process);
 
-    std::optional<uint16_t> read_memory(std::shared_ptr<Process> process, int virtual_address);
-    bool write_memory(std::shared_ptr<Process> process, int virtual_address, uint16_t value);
+    std::optional<uint16_t> read_memory(const std::shared_ptr<Process>& process, int virtual_address);
+    bool write_memory(const std::shared_ptr<Process>& process, int virtual_address, uint16_t value);
+
+    // Block operations over bytes starting at a virtual address, one page at a time
+    // with memory_mutex taken once per page. They resume from progress, which they
+    // advance page by page, and stop with PAGE_FAULT at the first page not resident.
+    BlockStatus fill_memory(const std::shared_ptr<Process>& process, int address, int bytes, uint16_t value, BlockProgress& progress, BlockFault& fault);
+    BlockStatus copy_memory(const std::shared_ptr<Process>& process, int destination, int source, int bytes, BlockProgress& progress, BlockFault& fault);
+    BlockStatus sum_memory(const std::shared_ptr<Process>& process, int address, int bytes, BlockProgress& progress, BlockFault& fault);
     
     bool handle_page_fault(std::shared_ptr<Process> process, int page_number);
 
     int get_total_memory() const;
+    int get_num_frames() const;
     int get_used_memory() const;
     int get_free_memory() const;
     int get_active_memory() const;
-    const PagingStats& get_paging_stats() const;
+    MemorySnapshot snapshot() const;
 
 private:
-    std::optional<int> find_free_frame();
-    int evict_page_fifo();
+    friend class ResidentFrames;
+
+    int evict_page();
+    PageTableEntry& frame_pte(int frame_number);
+    void write_frame(int frame_number);
+    void enqueue_frame(int frame_number);
+    void dequeue_frame(int frame_number);
+    bool pin_frame(const TlbEntry& entry);
+    void unpin_frame(int frame_number);
+    void shoot_down_frame(int frame_number);
+    PageTableEntry* find_pte(const Process& process, int page_number);
+    void fill_tlb(Process& process, int page_number, PageTableEntry& pte);
+    bool check_block(Process& process, int address, int bytes);
+    uint8_t* resident_page(Process& process, int page_number, bool write);
     void load_page_into_frame(int frame_number, std::shared_ptr<Process> process, int page_number);
 
     int total_memory_size;
@@ -60,15 +153,29 @@ private:
     int num_frames;
 
     std::vector<Frame> physical_frames;
+    std::vector<FrameGuard> frame_guards;
     std::vector<uint8_t> physical_memory;
-    std::map<int, std::vector<PageTableEntry>> page_tables;
+    std::vector<PageTable> page_tables;
+    std::vector<int> free_handles;
 
-    std::list<int> fifo_queue;
+    FrameBitmap free_frames;
+    int queue_head = -1;
+    int queue_tail = -1;
+    std::unique_ptr<ReplacementPolicy> policy;
+    ResidentFrames resident{*this};
     
     std::string backing_store_file = "csopesy-backing-store.txt";
     std::fstream backing_store;
     long long next_backing_store_pos = 0;
 
-    PagingStats stats;
+    // Updated under memory_mutex on every load, eviction and release, and read
+    // without it, so snapshots never contend with translation. active_pages counts
+    // pages that are present and accessed; policies other than FIFO clear
+    // ACCESSED as they scan, so for them it counts recently referenced pages.
+    alignas(64) std::atomic<int> used_frames{0};
+    std::atomic<int> active_pages{0};
+    std::atomic<uint64_t> page_ins{0};
+    std::atomic<uint64_t> page_outs{0};
+    std::atomic<uint64_t> page_writes{0};
     mutable std::mutex memory_mutex;
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Pager.h"
+#include "MemoryManager.h"
+#include <algorithm>
+
+Pager::Pager(MemoryManager* memory_manager, int frame_size, int num_threads, Completion on_resident)
+    : memory_manager(memory_manager), frame_size(frame_size), on_resident(move(on_resident)) {
+    // Leave room for the rest of memory, or a large range would evict its own pages.
+    max_pages_per_request = max(1, memory_manager->get_num_frames() / 2);
+    for (int i = 0; i < num_threads; ++i) {
+        pager_threads.emplace_back(&Pager::worker_loop, this);
+    }
+}
+
+Pager::~Pager() {
+    stop();
+}
+
+void Pager::stop() {
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        if (is_stopping) return;
+        is_stopping = true;
+    }
+    request_ready.notify_all();
+    for (auto& t : pager_threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void Pager::request(shared_ptr<Process> process, int faulting_address, int length) {
+    int first_page = faulting_address / frame_size;
+    int last_page = (faulting_address + max(length, 1) - 1) / frame_size;
+    int page_count = min(last_page - first_page + 1, max_pages_per_request);
+    PageRequest page_request{process, first_page, page_count, chrono::steady_clock::now()};
+    if (pager_threads.empty()) {
+        service(page_request);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(queue_mutex);
+        if (is_stopping) return;
+        pending.push_back(move(page_request));
+        depth = pending.size();
+        if (pending.size() > stats.max_queue_depth.load()) stats.max_queue_depth = pending.size();
+    }
+    request_ready.notify_one();
+}
+
+void Pager::worker_loop() {
+    while (true) {
+        PageRequest page_request;
+        {
+            unique_lock<mutex> lock(queue_mutex);
+            request_ready.wait(lock, [this] { return !pending.empty() || is_stopping; });
+            if (is_stopping) return;
+            page_request = move(pending.front());
+            pending.pop_front();
+            depth = pending.size();
+            in_service++;
+        }
+        service(page_request);
+        in_service--;
+    }
+}
+
+void Pager::service(const PageRequest& page_request) {
+    for (int i = 0; i < page_request.page_count; ++i) {
+        if (!memory_manager->handle_page_fault(page_request.process, page_request.first_page + i)) break;
+    }
+    auto elapsed = chrono::steady_clock::now() - page_request.requested_at;
+    stats.service_us.record(chrono::duration_cast<chrono::microseconds>(elapsed).count());
+    stats.faults_serviced++;
+    on_resident(page_request.process);
+}
+
+size_t Pager::queue_depth() const { return depth.load(); }
+bool Pager::is_busy() const { return depth.load() > 0 || in_service.load() > 0; }
+const PagerStats& Pager::get_stats() const { return stats; }
@@ -0,0 +1,69 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Process.h"
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+class MemoryManager;
+
+struct PagerStats {
+    LatencyHistogram service_us;
+    atomic<uint64_t> faults_serviced{0};
+    atomic<size_t> max_queue_depth{0};
+};
+
+// Pool of pager threads that service page faults off the cores. A faulting process
+// is handed over with request() and the core moves on; once the page is resident
+// the completion callback receives the process so it can be made ready again.
+// With zero threads, request() services the fault inline on the caller. A request
+// covers a range, so a block instruction gets all of its pages in one round trip.
+class Pager {
+public:
+    using Completion = function<void(shared_ptr<Process>)>;
+
+    Pager(MemoryManager* memory_manager, int frame_size, int num_threads, Completion on_resident);
+    ~Pager();
+
+    void request(shared_ptr<Process> process, int faulting_address, int length);
+    void stop();
+
+    size_t queue_depth() const;
+    bool is_busy() const;
+    const PagerStats& get_stats() const;
+
+private:
+    struct PageRequest {
+        shared_ptr<Process> process;
+        int first_page;
+        int page_count;
+        chrono::steady_clock::time_point requested_at;
+    };
+
+    void worker_loop();
+    void service(const PageRequest& page_request);
+
+    MemoryManager* memory_manager;
+    int frame_size;
+    int max_pages_per_request;
+    Completion on_resident;
+
+    deque<PageRequest> pending;
+    atomic<size_t> depth{0};
+    atomic<int> in_service{0};
+    bool is_stopping = false;
+    PagerStats stats;
+
+    vector<thread> pager_threads;
+    mutable mutex queue_mutex;
+    condition_variable request_ready;
+};
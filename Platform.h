@@ -0,0 +1,19 @@
+#pragma once
+#include <ctime>
+#include <cstdlib>
+
+// MSVC ships localtime_s; POSIX has the same thing as localtime_r with the
+// arguments swapped.
+#ifndef _WIN32
+inline int localtime_s(tm* result, const time_t* time) {
+    return localtime_r(time, result) ? 0 : -1;
+}
+#endif
+
+inline void clear_console() {
+#ifdef _WIN32
+    system("cls");
+#else
+    system("clear");
+#endif
+}
@@ -6,189 +6,372 @@
 #include <algorithm>
 #include <memory>
 
-Process::Process(int pid, const string& pname, vector<Instruction>&& inst, size_t final_total_instructions, const string& timestamp)
-    : id(pid), name(pname), instructions(move(inst)), total_instruction_count(final_total_instructions), creation_timestamp(timestamp) {
+Process::Process(int pid, const string& pname, ProgramImage image, const string& timestamp)
+    : id(pid), name(pname), creation_timestamp(timestamp), program(move(image)), tlb(make_unique<Tlb>()) {
     creation_time_t = time(nullptr);
+    print_lists = program->print_lists;
+    total_instruction_count = program->total_instructions;
+    loop_passes_left.reserve(program->max_loop_depth);
+    skip_control_ops();
+    arrival_time = state_entered_time = chrono::steady_clock::now();
 }
 
+// Called by the memory manager, possibly from inside run_slice, so it must not take
+// data_mutex. The FATAL log line is written by run_slice when it stops on the violation.
 void Process::set_memory_violation(int invalid_address) {
     if (!mem_violation.occurred) {
         mem_violation.occurred = true;
         mem_violation.address = invalid_address;
         mem_violation.timestamp = time(nullptr);
         is_finished = true;
-        
-        lock_guard<mutex> lock(data_mutex);
-        logs.push_back("FATAL: Memory Access Violation. Process terminated.");
     }
 }
 
-bool Process::is_sleeping(int current_tick) const { return sleep_until_tick.load() > current_tick; }
-size_t Process::get_executed_count() const { return instruction_pointer.load(); }
-size_t Process::get_total_instructions() const { return total_instruction_count; }
+static double elapsed_ms(chrono::steady_clock::time_point from, chrono::steady_clock::time_point to) {
+    return chrono::duration<double, milli>(to - from).count();
+}
+
+void Process::mark_arrival(int current_tick) {
+    lock_guard<mutex> lock(timing_mutex);
+    arrival_tick = state_entered_tick = current_tick;
+}
+
+// Returns true when this transition is the process's first dispatch onto a core.
+bool Process::transition_to(ProcessState next_state, int current_tick) {
+    lock_guard<mutex> lock(timing_mutex);
+    if (next_state == state || state == ProcessState::FINISHED) return false;
+    auto now = chrono::steady_clock::now();
+    ElapsedTime& total = state_totals[static_cast<int>(state)];
+    total.ticks += max(0, current_tick - state_entered_tick);
+    total.wall_ms += elapsed_ms(state_entered_time, now);
+    state = next_state;
+    state_entered_tick = current_tick;
+    state_entered_time = now;
 
-void Process::execute_instruction(MemoryManager* mem_manager, int core_id, int current_tick, int delay_per_exec) {
-    if (is_finished.load() || is_sleeping(current_tick)) {
-        return;
+    if (next_state == ProcessState::FINISHED) {
+        finished_tick = current_tick;
+        finished_time = now;
     }
-    if (instruction_pointer.load() >= instructions.size()) {
-        is_finished = true;
-        return;
+    if (next_state == ProcessState::RUNNING && first_run_tick == -1) {
+        first_run_tick = current_tick;
+        first_run_time = now;
+        return true;
     }
+    return false;
+}
+
+ProcessState Process::get_state() const {
+    lock_guard<mutex> lock(timing_mutex);
+    return state;
+}
+
+ElapsedTime Process::get_time_in_state(ProcessState query_state, int current_tick) const {
+    lock_guard<mutex> lock(timing_mutex);
+    ElapsedTime total = state_totals[static_cast<int>(query_state)];
+    if (query_state == state && state != ProcessState::FINISHED) {
+        total.ticks += max(0, current_tick - state_entered_tick);
+        total.wall_ms += elapsed_ms(state_entered_time, chrono::steady_clock::now());
+    }
+    return total;
+}
+
+ElapsedTime Process::get_response_time() const {
+    lock_guard<mutex> lock(timing_mutex);
+    if (first_run_tick == -1) return {};
+    return {static_cast<uint64_t>(max(0, first_run_tick - arrival_tick)), elapsed_ms(arrival_time, first_run_time)};
+}
 
-    needs_page_fault_handling = false; 
+ElapsedTime Process::get_turnaround_time() const {
+    lock_guard<mutex> lock(timing_mutex);
+    if (state != ProcessState::FINISHED) return {};
+    return {static_cast<uint64_t>(max(0, finished_tick.load() - arrival_tick)), elapsed_ms(arrival_time, finished_time)};
+}
+
+// Drops everything only needed while the process can still execute, leaving the
+// summary fields (name, PID, timestamps, counts, violation info) used by reports.
+// The print lists stay while log records, in the ring or the log store, still need
+// them to be formatted.
+void Process::release_execution_state() {
+    lock_guard<mutex> lock(data_mutex);
+    program.reset();
+    tlb.reset();
+    if (!stream_logs) logs.shrink(RETIRED_LOG_CAPACITY);
+    if (logs.empty()) print_lists.reset();
+    vector<uint16_t>().swap(loop_passes_left);
+    vector<LogRecord>().swap(unflushed_logs);
+}
+
+void Process::record_log(const LogRecord& record) {
+    if (stream_logs) unflushed_logs.push_back(record);
+    else logs.push(record);
+}
+
+vector<LogRecord> Process::get_log_records() const {
+    lock_guard<mutex> lock(data_mutex);
+    return logs.records();
+}
+
+vector<string> Process::format_log_records(const vector<LogRecord>& records) const {
+    lock_guard<mutex> lock(data_mutex);
+    vector<string> lines;
+    lines.reserve(records.size());
+    static const PrintLists no_print_lists;
+    const PrintLists& lists = print_lists ? *print_lists : no_print_lists;
+    for (const auto& record : records) lines.push_back(format_log_record(record, lists, name));
+    return lines;
+}
+
+uint64_t Process::get_dropped_log_count() const {
+    lock_guard<mutex> lock(data_mutex);
+    return logs.dropped();
+}
+
+bool Process::is_sleeping(int current_tick) const { return sleep_until_tick.load() > current_tick; }
+bool Process::missed_deadline(int current_tick) const {
+    if (absolute_deadline == NO_DEADLINE) return false;
+    int finish = finished_tick.load();
+    return (finish == -1) ? current_tick > absolute_deadline : finish > absolute_deadline;
+}
+size_t Process::get_executed_count() const { return executed_count.load(); }
+size_t Process::get_total_instructions() const { return total_instruction_count; }
 
-    const Instruction& instruction = instructions[instruction_pointer.load()];
-    
-    {
-        lock_guard<mutex> lock(data_mutex);
-        execute_single_instruction(instruction, mem_manager, core_id, current_tick);
+// Runs loop control until pc rests on an instruction or HALT, so the process is
+// marked finished as soon as its last instruction has run.
+void Process::skip_control_ops() {
+    while (true) {
+        const BytecodeOp& op = program->ops[pc];
+        if (op.code == OpCode::LOOP_BEGIN) {
+            loop_passes_left.push_back(op.operands[0]);
+            pc++;
+        } else if (op.code == OpCode::LOOP_END) {
+            if (--loop_passes_left.back() > 0) {
+                pc = op.address;
+            } else {
+                loop_passes_left.pop_back();
+                pc++;
+            }
+        } else {
+            return;
+        }
     }
+}
 
-    if (!needs_page_fault_handling.load()) {
-        instruction_pointer++;
-        if (delay_per_exec > 0) {
-            sleep_until_tick = current_tick + delay_per_exec;
+// Runs up to budget instructions under one data_mutex acquisition and reports why it
+// stopped. With a delay per instruction the process sleeps after every instruction,
+// so the budget is capped at one.
+SliceResult Process::run_slice(MemoryManager* mem_manager, int current_tick, size_t budget, int delay_per_exec) {
+    lock_guard<mutex> lock(data_mutex);
+    SliceResult result;
+    if (!is_finished.load() && !is_sleeping(current_tick) && program->ops[pc].code != OpCode::HALT) {
+        needs_page_fault_handling = false;
+        faulting_length = 0;
+        result.executed = run_bytecode(mem_manager, current_tick, delay_per_exec > 0 ? min<size_t>(budget, 1) : budget);
+        if (result.executed > 0) {
+            executed_count += result.executed;
+            if (delay_per_exec > 0) sleep_until_tick = current_tick + delay_per_exec;
         }
     }
-    
-    if (instruction_pointer.load() >= instructions.size()) {
+
+    if (mem_violation.occurred) {
+        if (!violation_logged) {
+            record_log({VIOLATION_RECORD, current_tick, static_cast<int16_t>(core_assigned), 0, 0, {}});
+            violation_logged = true;
+        }
+        result.reason = StopReason::VIOLATION;
+        result.address = mem_violation.address;
+    } else if (needs_page_fault_handling.load()) {
+        result.reason = StopReason::PAGE_FAULT;
+        result.address = faulting_address.load();
+        result.length = max<int>(faulting_length, sizeof(uint16_t));
+    } else if (is_finished.load() || program->ops[pc].code == OpCode::HALT) {
         is_finished = true;
+        result.reason = StopReason::FINISHED;
+    } else if (is_sleeping(current_tick)) {
+        result.reason = StopReason::SLEEPING;
+        result.sleep_until = sleep_until_tick.load();
     }
+    return result;
 }
 
-optional<uint16_t> Process::resolve_value(MemoryManager* mem_manager, const Value& value, int& address_out) {
-    if (holds_alternative<uint16_t>(value)) return get<uint16_t>(value);
-    if (holds_alternative<int>(value)) return static_cast<uint16_t>(get<int>(value));
+#if defined(__GNUC__) || defined(__clang__)
+#define CSOPESY_COMPUTED_GOTO
+#endif
 
-    const string& var_name = get<string>(value);
-    if (variable_offsets.find(var_name) == variable_offsets.end()) return 0;
+// Executes up to budget instructions starting at pc and returns how many completed.
+// Stops early when an instruction faults (pc stays on it so it is retried once the
+// page is resident), when SLEEP puts the process to sleep, or at HALT. Dispatch is
+// threaded through a label table where the compiler supports it.
+size_t Process::run_bytecode(MemoryManager* mem_manager, int current_tick, size_t budget) {
+    const shared_ptr<Process> self = shared_from_this();
+    const BytecodeOp* ops = program->ops.data();
+    const BytecodeOp* op = nullptr;
+    size_t executed = 0;
+    uint16_t lhs = 0, rhs = 0;
 
-    address_out = variable_offsets.at(var_name);
-    auto read_val = mem_manager->read_memory(shared_from_this(), address_out);
-    
-    if (!read_val) {
-        faulting_address = address_out;
+    // Reads operand i: an immediate, 0 for a variable not declared yet, or the
+    // variable's slot in the symbol table.
+    auto load = [&](int i, uint16_t& value) {
+        value = op->operands[i];
+        if (!(op->slot_mask & (1 << i))) return true;
+        if (!(declared_slots & (1u << value))) { value = 0; return true; }
+        int address = value * static_cast<int>(sizeof(uint16_t));
+        auto read_value = mem_manager->read_memory(self, address);
+        if (!read_value) {
+            faulting_address = address;
+            needs_page_fault_handling = true;
+            return false;
+        }
+        value = *read_value;
+        return true;
+    };
+    auto store = [&](int address, uint16_t value) {
+        if (mem_manager->write_memory(self, address, value)) return true;
+        faulting_address = address;
         needs_page_fault_handling = true;
-        return nullopt;
+        return false;
+    };
+    auto slot_address = [](uint16_t slot) { return slot * static_cast<int>(sizeof(uint16_t)); };
+    // A block operation that stopped on a page fault asks for the rest of its range,
+    // so the pager can load it all before the process runs again.
+    BlockFault fault;
+    auto block_done = [&](BlockStatus status) {
+        if (status == BlockStatus::DONE) return true;
+        if (status == BlockStatus::PAGE_FAULT) {
+            faulting_address = fault.address;
+            faulting_length = fault.length;
+            needs_page_fault_handling = true;
+        }
+        return false;
+    };
+
+#ifdef CSOPESY_COMPUTED_GOTO
+    static void* const labels[NUM_OPCODES] = {
+        &&op_NOP, &&op_DECLARE, &&op_ADD, &&op_SUBTRACT, &&op_PRINT, &&op_SLEEP,
+        &&op_READ, &&op_WRITE, &&op_LOOP_BEGIN, &&op_LOOP_END, &&op_HALT,
+        &&op_MEMSET, &&op_MEMCPY, &&op_SUM};
+#define CASE(name) op_##name
+#define DISPATCH() { op = &ops[pc]; goto *labels[static_cast<int>(op->code)]; }
+    DISPATCH();
+#else
+#define CASE(name) case OpCode::name
+#define DISPATCH() continue
+    for (;;) {
+    op = &ops[pc];
+    switch (op->code) {
+#endif
+
+// An instruction completed: move on, unless the budget is spent or it put the
+// process to sleep.
+#define COMPLETE() { \
+        pc++; \
+        if (++executed >= budget || is_sleeping(current_tick)) goto done; \
+        DISPATCH(); \
     }
-    return *read_val;
-}
-
-void Process::execute_single_instruction(const Instruction& instruction, MemoryManager* mem_manager, int core_id, int current_tick) {
-    int dummy_address;
-    
-    switch (instruction.type) {
-        case InstructionType::DECLARE: {
-            const string& var_name = get<string>(instruction.args[0]);
-            auto initial_value_opt = resolve_value(mem_manager, instruction.args[1], dummy_address);
-            if (!initial_value_opt) return;
-            if (variable_offsets.find(var_name) == variable_offsets.end()) {
-                if (next_variable_offset + sizeof(uint16_t) > SYMBOL_TABLE_SIZE) break;
-                variable_offsets[var_name] = next_variable_offset;
-                next_variable_offset += sizeof(uint16_t);
-            }
-            int var_address = variable_offsets.at(var_name);
-            if (!mem_manager->write_memory(shared_from_this(), var_address, *initial_value_opt)) {
-                 faulting_address = var_address;
-                 needs_page_fault_handling = true;
-            }
-            break;
+
+    CASE(NOP):
+        COMPLETE();
+    CASE(DECLARE):
+        if (!load(1, lhs)) goto done;
+        if (op->operands[0] != NO_SLOT) {
+            declared_slots |= 1u << op->operands[0];
+            if (!store(slot_address(op->operands[0]), lhs)) goto done;
         }
-        case InstructionType::ADD:
-        case InstructionType::SUBTRACT: {
-            const string& dest_var = get<string>(instruction.args[0]);
-            if (variable_offsets.find(dest_var) == variable_offsets.end()) break;
-            auto val1_opt = resolve_value(mem_manager, instruction.args[1], dummy_address);
-            if (!val1_opt) return;
-            auto val2_opt = resolve_value(mem_manager, instruction.args[2], dummy_address);
-            if (!val2_opt) return;
-            uint16_t result = (instruction.type == InstructionType::ADD) 
-                ? min((uint32_t)65535, (uint32_t)*val1_opt + *val2_opt)
-                : ((*val1_opt < *val2_opt) ? 0 : *val1_opt - *val2_opt);
-            int dest_address = variable_offsets.at(dest_var);
-            if (!mem_manager->write_memory(shared_from_this(), dest_address, result)) {
-                faulting_address = dest_address;
-                needs_page_fault_handling = true;
-            }
-            break;
+        COMPLETE();
+    CASE(ADD):
+        if (declared_slots & (1u << op->operands[0])) {
+            if (!load(1, lhs) || !load(2, rhs)) goto done;
+            if (!store(slot_address(op->operands[0]), static_cast<uint16_t>(min<uint32_t>(65535, uint32_t(lhs) + rhs)))) goto done;
         }
-        case InstructionType::READ: {
-            const string& var_name = get<string>(instruction.args[0]);
-            int read_address = get<int>(instruction.args[1]);
-            auto value_opt = mem_manager->read_memory(shared_from_this(), read_address);
-            if (!value_opt) {
-                faulting_address = read_address;
-                needs_page_fault_handling = true;
-                return;
-            }
-            if (variable_offsets.find(var_name) == variable_offsets.end()) {
-                if (next_variable_offset + sizeof(uint16_t) > SYMBOL_TABLE_SIZE) break;
-                variable_offsets[var_name] = next_variable_offset;
-                next_variable_offset += sizeof(uint16_t);
-            }
-            int var_address = variable_offsets.at(var_name);
-            if (!mem_manager->write_memory(shared_from_this(), var_address, *value_opt)) {
-                 faulting_address = var_address;
-                 needs_page_fault_handling = true;
-            }
-            break;
+        COMPLETE();
+    CASE(SUBTRACT):
+        if (declared_slots & (1u << op->operands[0])) {
+            if (!load(1, lhs) || !load(2, rhs)) goto done;
+            if (!store(slot_address(op->operands[0]), lhs < rhs ? 0 : lhs - rhs)) goto done;
         }
-        case InstructionType::WRITE: {
-            int write_address = get<int>(instruction.args[0]);
-            auto value_opt = resolve_value(mem_manager, instruction.args[1], dummy_address);
-            if (!value_opt) return;
-            if (!mem_manager->write_memory(shared_from_this(), write_address, *value_opt)) {
-                faulting_address = write_address;
+        COMPLETE();
+    CASE(PRINT): {
+        // Only the variable values are captured; the line is formatted when read.
+        LogRecord record{static_cast<uint32_t>(op->address), current_tick, static_cast<int16_t>(core_assigned), 0, 0, {}};
+        for (const auto& arg : (*print_lists)[op->address]) {
+            if (arg.kind != PrintArg::VARIABLE || record.value_count == MAX_LOG_VALUES) continue;
+            int index = record.value_count++;
+            if (!(declared_slots & (1u << arg.value))) {
+                record.undeclared_mask |= 1 << index;
+                continue;
+            }
+            auto read_value = mem_manager->read_memory(self, slot_address(arg.value));
+            if (!read_value) {
+                faulting_address = slot_address(arg.value);
                 needs_page_fault_handling = true;
+                goto done;
             }
-            break;
+            record.values[index] = *read_value;
         }
-        case InstructionType::SLEEP: {
-            if (!instruction.args.empty()) {
-                auto duration_opt = resolve_value(mem_manager, instruction.args[0], dummy_address);
-                if (!duration_opt) return;
-                sleep_until_tick = current_tick + *duration_opt;
-            }
-            break;
+        record_log(record);
+        COMPLETE();
+    }
+    CASE(SLEEP):
+        if (!load(0, lhs)) goto done;
+        sleep_until_tick = current_tick + lhs;
+        COMPLETE();
+    CASE(READ): {
+        auto read_value = mem_manager->read_memory(self, op->address);
+        if (!read_value) {
+            faulting_address = op->address;
+            needs_page_fault_handling = true;
+            goto done;
         }
-        case InstructionType::PRINT: {
-             ostringstream log_stream;
-             log_stream << "PRINT: ";
-             if (instruction.args.empty()) {
-                 log_stream << "Hello from " << name;
-             } else {
-                 for(const auto& arg : instruction.args) {
-                    if (holds_alternative<string>(arg)) {
-                        const string& str_arg = get<string>(arg);
-                        if (variable_offsets.find(str_arg) == variable_offsets.end()) {
-                            log_stream << str_arg;
-                        } else {
-                            auto val_opt = resolve_value(mem_manager, arg, dummy_address);
-                            if (!val_opt) return;
-                            log_stream << *val_opt;
-                        }
-                    } else {
-                        auto val_opt = resolve_value(mem_manager, arg, dummy_address);
-                        if (!val_opt) return;
-                        log_stream << *val_opt;
-                    }
-                 }
-             }
-             logs.push_back(log_stream.str());
-             break;
+        if (op->operands[0] != NO_SLOT) {
+            declared_slots |= 1u << op->operands[0];
+            if (!store(slot_address(op->operands[0]), *read_value)) goto done;
         }
-        case InstructionType::FOR: {
-            const vector<Instruction>& inner_block = instruction.for_block;
-            uint16_t repeat_count = instruction.for_repeats;
-            vector<Instruction> repeated_instructions;
-            repeated_instructions.reserve(inner_block.size() * repeat_count);
-            for (int i = 0; i < repeat_count; ++i) {
-                repeated_instructions.insert(repeated_instructions.end(), inner_block.begin(), inner_block.end());
-            }
-            size_t insert_pos = instruction_pointer.load() + 1;
-            instructions.insert(instructions.begin() + insert_pos, repeated_instructions.begin(), repeated_instructions.end());
-            break;
+        COMPLETE();
+    }
+    CASE(WRITE):
+        if (!load(0, lhs)) goto done;
+        if (!store(op->address, lhs)) goto done;
+        COMPLETE();
+    CASE(MEMSET):
+        if (!load(0, lhs)) goto done;
+        if (!block_done(mem_manager->fill_memory(self, op->address, op->operands[1] * 2, lhs, block_progress, fault))) goto done;
+        block_progress = {};
+        COMPLETE();
+    CASE(MEMCPY):
+        if (!block_done(mem_manager->copy_memory(self, op->address, op->operands[0], op->operands[1] * 2, block_progress, fault))) goto done;
+        block_progress = {};
+        COMPLETE();
+    CASE(SUM):
+        if (!block_done(mem_manager->sum_memory(self, op->address, op->operands[1] * 2, block_progress, fault))) goto done;
+        if (op->operands[0] != NO_SLOT) {
+            declared_slots |= 1u << op->operands[0];
+            if (!store(slot_address(op->operands[0]), static_cast<uint16_t>(min<uint64_t>(65535, block_progress.sum)))) goto done;
         }
+        block_progress = {};
+        COMPLETE();
+    CASE(LOOP_BEGIN):
+        loop_passes_left.push_back(op->operands[0]);
+        pc++;
+        DISPATCH();
+    CASE(LOOP_END):
+        if (--loop_passes_left.back() > 0) {
+            pc = op->address;
+        } else {
+            loop_passes_left.pop_back();
+            pc++;
+        }
+        DISPATCH();
+    CASE(HALT):
+        goto done;
+
+#ifndef CSOPESY_COMPUTED_GOTO
     }
-}
\ No newline at end of file
+    }
+#endif
+#undef COMPLETE
+#undef DISPATCH
+#undef CASE
+
+done:
+    skip_control_ops();
+    return executed;
+}
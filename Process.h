@@ -7,12 +7,57 @@
 #include <mutex>
 #include <optional>
 #include <memory>
-#include "Instruction.h"
+#include <climits>
+#include <array>
+#include <chrono>
+#include "Bytecode.h"
+#include "Tlb.h"
+#include "ProcessLog.h"
 
 using namespace std;
 
 class MemoryManager; 
 
+const int NO_DEADLINE = INT_MAX;
+
+enum class ProcessState {
+    READY,
+    RUNNING,
+    FAULT_BLOCKED,
+    SLEEPING,
+    FINISHED
+};
+const int NUM_PROCESS_STATES = 5;
+
+struct ElapsedTime {
+    uint64_t ticks = 0;
+    double wall_ms = 0.0;
+};
+
+// Why run_slice handed the core back.
+enum class StopReason {
+    QUANTUM_EXPIRED,  // the instruction budget was used up
+    PAGE_FAULT,       // [address, address + length) is not resident; retry once the pager loads it
+    SLEEPING,         // asleep until sleep_until
+    FINISHED,
+    VIOLATION         // address was outside the process's memory
+};
+
+struct SliceResult {
+    StopReason reason = StopReason::QUANTUM_EXPIRED;
+    size_t executed = 0;
+    int address = -1;
+    int length = 0;
+    int sleep_until = 0;
+};
+
+// How far a block operation got. It stops on the first page that is not resident
+// and picks up from there once the pager has loaded the rest of the range.
+struct BlockProgress {
+    int done = 0;      // bytes already processed
+    uint64_t sum = 0;  // running total of SUM
+};
+
 struct MemoryViolation {
     bool occurred = false;
     int address = 0;
@@ -26,39 +71,77 @@ public:
     string creation_timestamp;
     time_t creation_time_t;
 
-    vector<Instruction> instructions;
+    ProgramImage program;
+    shared_ptr<const PrintLists> print_lists;
     
-    atomic<size_t> instruction_pointer{0};
+    atomic<size_t> executed_count{0};
     atomic<bool> is_finished{false}; 
     atomic<bool> needs_page_fault_handling{false};
     atomic<int> faulting_address{-1}; 
+    int faulting_length = 0;
     int core_assigned = -1;
+    atomic<int> priority_level{0};
+    int absolute_deadline = NO_DEADLINE;
+    atomic<int> finished_tick{-1};
 
     int memory_size = 0;   
+    int memory_handle = -1;  // index of its page table in the memory manager
     MemoryViolation mem_violation;
+    unique_ptr<Tlb> tlb;  // freed when the process retires
     static const int SYMBOL_TABLE_SIZE = 64;
 
     atomic<int> sleep_until_tick{0}; 
 
-    vector<string> logs;
+    // With stream_logs set, records go to unflushed_logs instead of the ring and the
+    // scheduler moves them to the log store after every batch of a slice and when the
+    // slice ends. unflushed_logs is only touched by the core running the process.
+    LogRing logs;
+    bool stream_logs = false;
+    vector<LogRecord> unflushed_logs;
     mutable mutex data_mutex; 
     
-    Process(int pid, const string& pname, vector<Instruction>&& inst, size_t final_total_instructions, const string& timestamp);
+    Process(int pid, const string& pname, ProgramImage image, const string& timestamp);
 
-    void execute_instruction(MemoryManager* mem_manager, int core_id, int current_tick, int delay_per_exec);
+    SliceResult run_slice(MemoryManager* mem_manager, int current_tick, size_t budget, int delay_per_exec);
     
     size_t get_executed_count() const;
     size_t get_total_instructions() const;
     bool is_sleeping(int current_tick) const; 
+    bool missed_deadline(int current_tick) const;
 
     void set_memory_violation(int address);
+    void release_execution_state();
+    vector<LogRecord> get_log_records() const;
+    vector<string> format_log_records(const vector<LogRecord>& records) const;
+    uint64_t get_dropped_log_count() const;
+
+    void mark_arrival(int current_tick);
+    bool transition_to(ProcessState next_state, int current_tick);
+    ProcessState get_state() const;
+    ElapsedTime get_time_in_state(ProcessState state, int current_tick) const;
+    ElapsedTime get_response_time() const;
+    ElapsedTime get_turnaround_time() const;
 
 private:
-    unordered_map<string, int> variable_offsets;
-    int next_variable_offset = 0;
+    size_t total_instruction_count;
+    size_t pc = 0;
+    vector<uint16_t> loop_passes_left;
+    uint32_t declared_slots = 0;
+    BlockProgress block_progress;
+    bool violation_logged = false;
 
-    size_t total_instruction_count; 
+    ProcessState state = ProcessState::READY;
+    int arrival_tick = 0;
+    int state_entered_tick = 0;
+    int first_run_tick = -1;
+    chrono::steady_clock::time_point arrival_time;
+    chrono::steady_clock::time_point state_entered_time;
+    chrono::steady_clock::time_point first_run_time;
+    chrono::steady_clock::time_point finished_time;
+    array<ElapsedTime, NUM_PROCESS_STATES> state_totals{};
+    mutable mutex timing_mutex;
 
-    optional<uint16_t> resolve_value(MemoryManager* mem_manager, const Value& value, int& address);
-    void execute_single_instruction(const Instruction& instr, MemoryManager* mem_manager, int core_id, int current_tick);
+    size_t run_bytecode(MemoryManager* mem_manager, int current_tick, size_t budget);
+    void record_log(const LogRecord& record);
+    void skip_control_ops();
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "ProcessLog.h"
+#include <sstream>
+#include <algorithm>
+
+LogRing::LogRing(size_t capacity) : capacity(max<size_t>(capacity, 1)) {}
+
+void LogRing::push(const LogRecord& record) {
+    if (buffer.size() < capacity) {
+        buffer.push_back(record);
+        return;
+    }
+    buffer[oldest] = record;
+    oldest = (oldest + 1) % capacity;
+    dropped_count++;
+}
+
+void LogRing::clear() {
+    vector<LogRecord>().swap(buffer);
+    oldest = 0;
+}
+
+void LogRing::shrink(size_t new_capacity) {
+    new_capacity = max<size_t>(new_capacity, 1);
+    if (new_capacity >= capacity) return;
+    vector<LogRecord> ordered = records();
+    size_t kept = min(ordered.size(), new_capacity);
+    dropped_count += ordered.size() - kept;
+    buffer.assign(ordered.end() - kept, ordered.end());
+    buffer.shrink_to_fit();
+    capacity = new_capacity;
+    oldest = 0;
+}
+
+size_t LogRing::size() const { return buffer.size(); }
+bool LogRing::empty() const { return buffer.empty(); }
+uint64_t LogRing::dropped() const { return dropped_count; }
+
+vector<LogRecord> LogRing::records() const {
+    vector<LogRecord> ordered;
+    ordered.reserve(buffer.size());
+    ordered.insert(ordered.end(), buffer.begin() + oldest, buffer.end());
+    ordered.insert(ordered.end(), buffer.begin(), buffer.begin() + oldest);
+    return ordered;
+}
+
+string format_log_record(const LogRecord& record, const vector<vector<PrintArg>>& print_lists, const string& process_name) {
+    ostringstream line;
+    line << "(tick " << record.tick << ") Core:" << record.core << " ";
+    if (record.print_index == VIOLATION_RECORD) {
+        line << "FATAL: Memory Access Violation. Process terminated.";
+        return line.str();
+    }
+    line << "PRINT: ";
+    if (record.print_index >= print_lists.size()) return line.str();
+    const vector<PrintArg>& args = print_lists[record.print_index];
+    if (args.empty()) line << "Hello from " << process_name;
+    int variable = 0;
+    for (const auto& arg : args) {
+        if (arg.kind == PrintArg::TEXT) {
+            line << arg.text;
+        } else if (arg.kind == PrintArg::VALUE) {
+            line << arg.value;
+        } else {
+            int index = variable++;
+            if (index >= record.value_count || (record.undeclared_mask & (1 << index))) line << arg.text;
+            else line << record.values[index];
+        }
+    }
+    return line.str();
+}
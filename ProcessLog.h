@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Bytecode.h"
+
+using namespace std;
+
+const size_t DEFAULT_LOG_CAPACITY = 1024;
+// Records a finished process keeps when logs are not archived: one screen -r page.
+const size_t RETIRED_LOG_CAPACITY = 20;
+// A PRINT records at most this many variables; any after that print as their name.
+const int MAX_LOG_VALUES = 8;
+const uint32_t VIOLATION_RECORD = 0xFFFFFFFF;
+
+// One log line as the interpreter recorded it: which PRINT ran, on which tick and
+// core, and the values its variables had. The text is only built by format_log_record.
+struct LogRecord {
+    uint32_t print_index;     // into CompiledProgram::print_lists, or VIOLATION_RECORD
+    int32_t tick;
+    int16_t core;
+    uint8_t undeclared_mask;  // bit i: variable i was not declared yet, so its name is printed
+    uint8_t value_count;
+    uint16_t values[MAX_LOG_VALUES];
+};
+
+// Fixed-capacity ring of a process's most recent log records. Storage grows on
+// demand up to the capacity; after that each new record overwrites the oldest one,
+// which is counted as dropped.
+class LogRing {
+public:
+    explicit LogRing(size_t capacity = DEFAULT_LOG_CAPACITY);
+
+    void push(const LogRecord& record);
+    void clear();
+    // Keeps only the newest capacity records, counting the rest as dropped, and
+    // frees the storage beyond them.
+    void shrink(size_t capacity);
+    size_t size() const;
+    bool empty() const;
+    uint64_t dropped() const;
+
+    // Records from oldest to newest.
+    vector<LogRecord> records() const;
+
+private:
+    vector<LogRecord> buffer;
+    size_t capacity;
+    size_t oldest = 0;
+    uint64_t dropped_count = 0;
+};
+
+string format_log_record(const LogRecord& record, const vector<vector<PrintArg>>& print_lists, const string& process_name);
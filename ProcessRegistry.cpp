@@ -0,0 +1,74 @@
+#include "ProcessRegistry.h"
+
+bool ProcessRegistry::add(shared_ptr<Process> process) {
+    unique_lock<shared_mutex> lock(registry_mutex);
+    if (!by_name.emplace(process->name, process).second) return false;
+    by_pid[process->id] = process;
+    running_set[process->id] = move(process);
+    num_running = running_set.size();
+    return true;
+}
+
+void ProcessRegistry::mark_finished(int pid) {
+    unique_lock<shared_mutex> lock(registry_mutex);
+    auto it = running_set.find(pid);
+    if (it == running_set.end()) return;
+    auto& retired_set = it->second->mem_violation.occurred ? faulted_set : finished_set;
+    retired_set[pid] = move(it->second);
+    running_set.erase(it);
+    num_running = running_set.size();
+    num_finished = finished_set.size();
+    num_faulted = faulted_set.size();
+}
+
+shared_ptr<Process> ProcessRegistry::find(const string& name) const {
+    shared_lock<shared_mutex> lock(registry_mutex);
+    auto it = by_name.find(name);
+    return (it == by_name.end()) ? nullptr : it->second;
+}
+
+shared_ptr<Process> ProcessRegistry::find(int pid) const {
+    shared_lock<shared_mutex> lock(registry_mutex);
+    auto it = by_pid.find(pid);
+    return (it == by_pid.end()) ? nullptr : it->second;
+}
+
+vector<shared_ptr<Process>> ProcessRegistry::values(const map<int, shared_ptr<Process>>& set) {
+    vector<shared_ptr<Process>> result;
+    result.reserve(set.size());
+    for (const auto& entry : set) result.push_back(entry.second);
+    return result;
+}
+
+// Both inputs must be in PID order; so is the result.
+vector<shared_ptr<Process>> ProcessRegistry::merged(const vector<shared_ptr<Process>>& a, const vector<shared_ptr<Process>>& b) {
+    vector<shared_ptr<Process>> result;
+    result.reserve(a.size() + b.size());
+    auto a_it = a.begin();
+    auto b_it = b.begin();
+    while (a_it != a.end() || b_it != b.end()) {
+        bool take_a = b_it == b.end() || (a_it != a.end() && (*a_it)->id < (*b_it)->id);
+        result.push_back(take_a ? *a_it++ : *b_it++);
+    }
+    return result;
+}
+
+vector<shared_ptr<Process>> ProcessRegistry::running() const {
+    shared_lock<shared_mutex> lock(registry_mutex);
+    return values(running_set);
+}
+
+vector<shared_ptr<Process>> ProcessRegistry::retired() const {
+    shared_lock<shared_mutex> lock(registry_mutex);
+    return merged(values(finished_set), values(faulted_set));
+}
+
+vector<shared_ptr<Process>> ProcessRegistry::all() const {
+    shared_lock<shared_mutex> lock(registry_mutex);
+    return merged(values(running_set), merged(values(finished_set), values(faulted_set)));
+}
+
+size_t ProcessRegistry::running_count() const { return num_running.load(); }
+size_t ProcessRegistry::finished_count() const { return num_finished.load(); }
+size_t ProcessRegistry::faulted_count() const { return num_faulted.load(); }
+size_t ProcessRegistry::retired_count() const { return num_finished.load() + num_faulted.load(); }
@@ -0,0 +1,51 @@
+#pragma once
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <string>
+#include <memory>
+#include <shared_mutex>
+#include <atomic>
+#include "Process.h"
+
+using namespace std;
+
+// Indexes every admitted process by name and PID and keeps running, finished and
+// memory-faulted sets up to date as processes finish, so lookups are O(1) and
+// listings only touch the processes they return. A process is in exactly one set;
+// retired() is the finished and faulted ones together. Sets are keyed by PID to
+// keep listings in creation order.
+class ProcessRegistry {
+public:
+    bool add(shared_ptr<Process> process);
+    void mark_finished(int pid);
+
+    shared_ptr<Process> find(const string& name) const;
+    shared_ptr<Process> find(int pid) const;
+
+    vector<shared_ptr<Process>> running() const;
+    vector<shared_ptr<Process>> retired() const;
+    vector<shared_ptr<Process>> all() const;
+
+    size_t running_count() const;
+    // Processes that ran to completion; memory-faulted ones are only in faulted_count.
+    size_t finished_count() const;
+    size_t faulted_count() const;
+    size_t retired_count() const;
+
+private:
+    static vector<shared_ptr<Process>> values(const map<int, shared_ptr<Process>>& set);
+    static vector<shared_ptr<Process>> merged(const vector<shared_ptr<Process>>& a, const vector<shared_ptr<Process>>& b);
+
+    unordered_map<string, shared_ptr<Process>> by_name;
+    unordered_map<int, shared_ptr<Process>> by_pid;
+    map<int, shared_ptr<Process>> running_set;
+    map<int, shared_ptr<Process>> finished_set;
+    map<int, shared_ptr<Process>> faulted_set;
+    // Set sizes mirrored under the lock so the counts can be read without it.
+    atomic<size_t> num_running{0};
+    atomic<size_t> num_finished{0};
+    atomic<size_t> num_faulted{0};
+
+    mutable shared_mutex registry_mutex;
+};
@@ -0,0 +1,35 @@
+#include "ProgramCache.h"
+#include <algorithm>
+
+ProgramImage ProgramImageCache::intern(CompiledProgram&& program) {
+    uint64_t hash = hash_program(program);
+    lock_guard<mutex> lock(cache_mutex);
+    auto range = images.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        ProgramImage image = it->second.lock();
+        if (image && same_program(*image, program)) return image;
+    }
+    ProgramImage image = make_shared<const CompiledProgram>(move(program));
+    images.emplace(hash, image);
+    if (images.size() >= prune_threshold) prune_expired();
+    return image;
+}
+
+// Caller holds cache_mutex. The threshold doubles past the live count so pruning
+// stays amortized O(1) per intern.
+void ProgramImageCache::prune_expired() {
+    for (auto it = images.begin(); it != images.end();) {
+        if (it->second.expired()) it = images.erase(it);
+        else ++it;
+    }
+    prune_threshold = max<size_t>(64, images.size() * 2);
+}
+
+size_t ProgramImageCache::live_images() const {
+    lock_guard<mutex> lock(cache_mutex);
+    size_t live = 0;
+    for (const auto& entry : images) {
+        if (!entry.second.expired()) live++;
+    }
+    return live;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "Bytecode.h"
+
+using namespace std;
+
+// Interns compiled programs by content, so processes running the same program share
+// one immutable image and each process only owns its pc, loop counters and symbol
+// table. The cache holds weak references; an image is freed with its last process
+// and its entry is pruned on a later intern.
+class ProgramImageCache {
+public:
+    ProgramImage intern(CompiledProgram&& program);
+    size_t live_images() const;
+
+private:
+    void prune_expired();
+
+    unordered_multimap<uint64_t, weak_ptr<const CompiledProgram>> images;
+    size_t prune_threshold = 64;
+    mutable mutex cache_mutex;
+};
@@ -0,0 +1,340 @@
+#include "ProgramLoader.h"
+#include <optional>
+#include <utility>
+#include <algorithm>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile(const string& path) {
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) { file_handle = nullptr; return; }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)) return;
+    size = static_cast<size_t>(file_size.QuadPart);
+    opened = true;
+    if (size == 0) return;
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle) data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) opened = false;
+}
+
+MappedFile::~MappedFile() {
+    if (data) UnmapViewOfFile(data);
+    if (mapping_handle) CloseHandle(mapping_handle);
+    if (file_handle) CloseHandle(file_handle);
+}
+#else
+MappedFile::MappedFile(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        size = static_cast<size_t>(info.st_size);
+        opened = true;
+        // mmap rejects zero-length mappings, and an empty file needs none.
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                opened = false;
+            } else {
+                data = static_cast<const char*>(mapped);
+                madvise(mapped, size, MADV_SEQUENTIAL);
+            }
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data) munmap(const_cast<char*>(data), size);
+}
+#endif
+
+bool MappedFile::is_open() const { return opened; }
+string_view MappedFile::contents() const { return data ? string_view(data, size) : string_view(); }
+
+namespace {
+
+// The bytecode compiler lowers nested loops recursively, so nesting depth is capped.
+const int MAX_FOR_DEPTH = 64;
+
+struct Token {
+    string_view text;
+    bool quoted;
+};
+
+class ProgramScanner {
+public:
+    explicit ProgramScanner(string_view source) : source(source) {}
+
+    ParseResult parse() {
+        blocks.emplace_back();
+        vector<Token> tokens;
+        while (position < source.size()) {
+            if (!next_statement(tokens)) return fail(error);
+            if (tokens.empty()) continue;
+            if (!strip_call_form(tokens) || !parse_statement(tokens)) return fail(error);
+        }
+        if (!open_loops.empty()) {
+            statement_line = open_loops.back().line;
+            return fail("FOR is never closed with END");
+        }
+        result.instructions = move(blocks.back());
+        return move(result);
+    }
+
+private:
+    struct OpenLoop {
+        uint16_t repeats;
+        int line;
+    };
+
+    ParseResult fail(const string& message) {
+        ParseResult failed;
+        failed.error_line = statement_line;
+        failed.error = message;
+        return failed;
+    }
+
+    // Any control character other than a newline separates tokens like a space.
+    static bool is_space(char c) { return static_cast<unsigned char>(c) <= ' ' && c != '\n'; }
+    // Parentheses, commas and '+' are tokens of their own, so KEYWORD(a, b) and
+    // "text"+x split without spaces.
+    static bool is_punctuation(char c) { return c == '(' || c == ')' || c == ',' || c == '+'; }
+    static bool is_word_end(char c) { return static_cast<unsigned char>(c) <= ' ' || c == ';' || c == '#' || c == '"' || is_punctuation(c); }
+    // A quote may be escaped as \" by text that was itself quoted for screen -c.
+    static bool is_quote(const char* p, const char* end) { return *p == '"' || (*p == '\\' && p + 1 < end && p[1] == '"'); }
+
+    // Splits the next statement into tokens, leaving position after its separator.
+    // Works on local pointers so the compiler keeps them in registers.
+    bool next_statement(vector<Token>& tokens) {
+        tokens.clear();
+        statement_line = line;
+        const char* const begin = source.data();
+        const char* const end = begin + source.size();
+        const char* p = begin + position;
+        while (p < end) {
+            char c = *p;
+            if (is_space(c)) {
+                p++;
+            } else if (c == '\n' || c == ';') {
+                p++;
+                if (c == '\n') line++;
+                break;
+            } else if (c == '#') {
+                while (p < end && *p != '\n') p++;
+            } else if (is_quote(p, end)) {
+                const char* open = (c == '"') ? p + 1 : p + 2;
+                const char* close = open;
+                while (close < end && *close != '"' && *close != '\n') close++;
+                if (close == end || *close != '"') {
+                    position = close - begin;
+                    error = "unterminated string";
+                    return false;
+                }
+                const char* text_end = (close > open && close[-1] == '\\') ? close - 1 : close;
+                tokens.push_back({string_view(open, text_end - open), true});
+                p = close + 1;
+            } else if (is_punctuation(c)) {
+                tokens.push_back({string_view(p, 1), false});
+                p++;
+            } else {
+                const char* start = p;
+                while (p < end && !is_word_end(*p) && !is_quote(p, end)) p++;
+                tokens.push_back({string_view(start, p - start), false});
+            }
+        }
+        position = p - begin;
+        return true;
+    }
+
+    static bool is_identifier(string_view text) {
+        if (text.empty() || !(isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_')) return false;
+        for (char c : text) {
+            if (!(isalnum(static_cast<unsigned char>(c)) || c == '_')) return false;
+        }
+        return true;
+    }
+
+    // Hex literals become int and decimal ones uint16_t, as the bytecode compiler expects.
+    static optional<Value> number(string_view text) {
+        bool hex = text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+        string_view digits = hex ? text.substr(2) : text;
+        if (digits.empty() || digits.size() > 5) return nullopt;
+        int value = 0;
+        for (char c : digits) {
+            int digit;
+            if (c >= '0' && c <= '9') digit = c - '0';
+            else if (hex && c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+            else if (hex && c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+            else return nullopt;
+            value = value * (hex ? 16 : 10) + digit;
+        }
+        if (value > 0xFFFF) return nullopt;
+        if (hex) return Value(value);
+        return Value(static_cast<uint16_t>(value));
+    }
+
+    bool expect_count(const Token& keyword, const vector<Token>& tokens, size_t min_args, size_t max_args) {
+        size_t args = tokens.size() - 1;
+        if (args >= min_args && args <= max_args) return true;
+        string expected = (min_args == max_args) ? to_string(min_args) : to_string(min_args) + " to " + to_string(max_args);
+        error = string(keyword.text) + " expects " + expected + " argument" + (max_args == 1 ? "" : "s") + ", got " + to_string(args);
+        return false;
+    }
+
+    bool variable(const Token& token, vector<Value>& args) {
+        if (token.quoted || !is_identifier(token.text)) {
+            error = "expected a variable name, got '" + string(token.text) + "'";
+            return false;
+        }
+        args.emplace_back(in_place_type<string>, token.text);
+        return true;
+    }
+
+    bool literal(const Token& token, vector<Value>& args) {
+        optional<Value> value = token.quoted ? nullopt : number(token.text);
+        if (!value) {
+            error = "expected a number from 0 to 65535, got '" + string(token.text) + "'";
+            return false;
+        }
+        args.push_back(move(*value));
+        return true;
+    }
+
+    bool operand(const Token& token, vector<Value>& args) {
+        if (!token.quoted && is_identifier(token.text)) return variable(token, args);
+        return literal(token, args);
+    }
+
+    static bool is_symbol(const Token& token, char symbol) {
+        return !token.quoted && token.text.size() == 1 && token.text[0] == symbol;
+    }
+
+    // Rewrites the call form KEYWORD(a, b) as KEYWORD a b.
+    bool strip_call_form(vector<Token>& tokens) {
+        if (tokens.size() < 2 || !is_symbol(tokens[1], '(')) return true;
+        if (!is_symbol(tokens.back(), ')')) {
+            error = string(tokens[0].text) + "( is never closed with ')'";
+            return false;
+        }
+        tokens.pop_back();
+        tokens.erase(tokens.begin() + 1);
+        tokens.erase(remove_if(tokens.begin() + 1, tokens.end(), [](const Token& token) { return is_symbol(token, ','); }), tokens.end());
+        return true;
+    }
+
+    bool parse_statement(const vector<Token>& tokens) {
+        const Token& keyword = tokens[0];
+        string_view name = keyword.text;
+
+        if (name == "FOR") {
+            if (!expect_count(keyword, tokens, 1, 1)) return false;
+            vector<Value> repeats;
+            if (!literal(tokens[1], repeats)) return false;
+            if (static_cast<int>(open_loops.size()) >= MAX_FOR_DEPTH) {
+                error = "FOR loops nest deeper than " + to_string(MAX_FOR_DEPTH);
+                return false;
+            }
+            uint16_t count = holds_alternative<int>(repeats[0]) ? static_cast<uint16_t>(get<int>(repeats[0])) : get<uint16_t>(repeats[0]);
+            open_loops.push_back({count, statement_line});
+            blocks.emplace_back();
+            result.statement_count++;
+            return true;
+        }
+        if (name == "END") {
+            if (!expect_count(keyword, tokens, 0, 0)) return false;
+            if (open_loops.empty()) {
+                error = "END without a matching FOR";
+                return false;
+            }
+            Instruction loop;
+            loop.type = InstructionType::FOR;
+            loop.for_repeats = open_loops.back().repeats;
+            loop.for_block = move(blocks.back());
+            open_loops.pop_back();
+            blocks.pop_back();
+            blocks.back().push_back(move(loop));
+            return true;
+        }
+
+        Instruction instruction;
+        vector<Value>& args = instruction.args;
+        args.reserve(tokens.size() - 1);
+        bool parsed;
+        if (name == "DECLARE") {
+            instruction.type = InstructionType::DECLARE;
+            parsed = expect_count(keyword, tokens, 1, 2) && variable(tokens[1], args) && (tokens.size() < 3 || operand(tokens[2], args));
+        } else if (name == "ADD" || name == "SUBTRACT") {
+            instruction.type = (name == "ADD") ? InstructionType::ADD : InstructionType::SUBTRACT;
+            parsed = expect_count(keyword, tokens, 3, 3) && variable(tokens[1], args) && operand(tokens[2], args) && operand(tokens[3], args);
+        } else if (name == "READ") {
+            instruction.type = InstructionType::READ;
+            parsed = expect_count(keyword, tokens, 2, 2) && variable(tokens[1], args) && literal(tokens[2], args);
+        } else if (name == "WRITE") {
+            instruction.type = InstructionType::WRITE;
+            parsed = expect_count(keyword, tokens, 2, 2) && literal(tokens[1], args) && operand(tokens[2], args);
+        } else if (name == "SLEEP") {
+            instruction.type = InstructionType::SLEEP;
+            parsed = expect_count(keyword, tokens, 1, 1) && operand(tokens[1], args);
+        } else if (name == "MEMSET") {
+            instruction.type = InstructionType::MEMSET;
+            parsed = expect_count(keyword, tokens, 3, 3) && literal(tokens[1], args) && literal(tokens[2], args) && operand(tokens[3], args);
+        } else if (name == "MEMCPY") {
+            instruction.type = InstructionType::MEMCPY;
+            parsed = expect_count(keyword, tokens, 3, 3) && literal(tokens[1], args) && literal(tokens[2], args) && literal(tokens[3], args);
+        } else if (name == "SUM") {
+            instruction.type = InstructionType::SUM;
+            parsed = expect_count(keyword, tokens, 3, 3) && variable(tokens[1], args) && literal(tokens[2], args) && literal(tokens[3], args);
+        } else if (name == "PRINT") {
+            // Text, variables and numbers are printed back to back; a '+' between them is optional.
+            instruction.type = InstructionType::PRINT;
+            parsed = true;
+            for (size_t i = 1; i < tokens.size() && parsed; ++i) {
+                if (tokens[i].quoted) args.emplace_back(in_place_type<string>, tokens[i].text);
+                else if (tokens[i].text != "+") parsed = operand(tokens[i], args);
+            }
+        } else {
+            error = "unknown instruction '" + string(name) + "'";
+            return false;
+        }
+        if (!parsed) return false;
+        blocks.back().push_back(move(instruction));
+        result.statement_count++;
+        return true;
+    }
+
+    string_view source;
+    size_t position = 0;
+    int line = 1;
+    int statement_line = 1;
+    string error;
+    vector<vector<Instruction>> blocks;
+    vector<OpenLoop> open_loops;
+    ParseResult result;
+};
+
+}
+
+ParseResult parse_program(string_view source) {
+    return ProgramScanner(source).parse();
+}
+
+ParseResult load_program_file(const string& path) {
+    MappedFile file(path);
+    if (!file.is_open()) {
+        ParseResult failed;
+        failed.error = "could not open " + path;
+        return failed;
+    }
+    return parse_program(file.contents());
+}
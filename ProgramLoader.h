@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Instruction.h"
+
+using namespace std;
+
+// Read-only view of a whole file, memory-mapped so a large program source is
+// scanned in place instead of being copied.
+class MappedFile {
+public:
+    explicit MappedFile(const string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const;
+    string_view contents() const;
+
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+struct ParseResult {
+    vector<Instruction> instructions;
+    size_t statement_count = 0;  // every instruction written, including FOR and loop bodies
+    int error_line = 0;
+    string error;                // empty when the whole source parsed
+
+    bool ok() const { return error.empty(); }
+};
+
+// Instructions are separated by newlines or ';', and '#' starts a comment that runs
+// to the end of the line. FOR <repeats> opens a loop whose body runs until the
+// matching END; loops nest. Numbers are decimal, or hex with a 0x prefix, and PRINT
+// takes quoted text as well as variables and numbers. Arguments may also be written
+// as a call, PRINT("x is " + x), and \" works as a quote. Parsing stops at the
+// first error, which is reported with its line number.
+ParseResult parse_program(string_view source);
+ParseResult load_program_file(const string& path);
@@ -0,0 +1,143 @@
+#include "ReplacementPolicy.h"
+#include <algorithm>
+
+bool parse_replacement_kind(const std::string& text, ReplacementKind& kind) {
+    if (text == "fifo") kind = ReplacementKind::FIFO;
+    else if (text == "clock") kind = ReplacementKind::CLOCK;
+    else if (text == "second-chance") kind = ReplacementKind::SECOND_CHANCE;
+    else if (text == "lru") kind = ReplacementKind::LRU;
+    else if (text == "wsclock") kind = ReplacementKind::WSCLOCK;
+    else return false;
+    return true;
+}
+
+const char* replacement_kind_name(ReplacementKind kind) {
+    switch (kind) {
+        case ReplacementKind::CLOCK: return "clock";
+        case ReplacementKind::SECOND_CHANCE: return "second-chance";
+        case ReplacementKind::LRU: return "lru";
+        case ReplacementKind::WSCLOCK: return "wsclock";
+        default: return "fifo";
+    }
+}
+
+namespace {
+
+class FifoPolicy : public ReplacementPolicy {
+public:
+    const char* name() const override { return "fifo"; }
+    int choose_victim(ResidentFrames& frames) override { return frames.oldest(); }
+};
+
+// Evicts the oldest frame not referenced since the hand last passed it. After one
+// full turn every bit is clear, so the loop ends within size() + 1 steps.
+class ClockPolicy : public ReplacementPolicy {
+public:
+    const char* name() const override { return "clock"; }
+    int choose_victim(ResidentFrames& frames) override {
+        while (true) {
+            int frame = frames.oldest();
+            if (!frames.test_and_clear_referenced(frame)) return frame;
+            frames.requeue(frame);
+        }
+    }
+};
+
+// Enhanced second chance: prefers an unreferenced clean frame, then an
+// unreferenced dirty one, clearing referenced bits on the second pass. Two rounds
+// always find a victim, since the second pass leaves every bit clear.
+class SecondChancePolicy : public ReplacementPolicy {
+public:
+    const char* name() const override { return "second-chance"; }
+    int choose_victim(ResidentFrames& frames) override {
+        while (true) {
+            for (int frame = frames.oldest(); frame != -1; frame = frames.next(frame)) {
+                if (!frames.is_referenced(frame) && !frames.is_dirty(frame)) return frame;
+            }
+            for (int i = frames.size(); i > 0; --i) {
+                int frame = frames.oldest();
+                if (!frames.test_and_clear_referenced(frame)) return frame;
+                frames.requeue(frame);
+            }
+        }
+    }
+};
+
+// LRU approximated by aging: each eviction shifts every resident frame's counter
+// right and sets its top bit if the frame was referenced since, then evicts the
+// lowest counter, the oldest frame on a tie. That makes an eviction O(resident
+// frames), and clears every frame's TLB entries once per eviction.
+class AgingPolicy : public ReplacementPolicy {
+public:
+    explicit AgingPolicy(int num_frames) : ages(num_frames, 0) {}
+
+    const char* name() const override { return "lru"; }
+    // A new page counts as just referenced, so it is not evicted before first use.
+    void on_load(ResidentFrames&, int frame) override { ages[frame] = 0x80; }
+    int choose_victim(ResidentFrames& frames) override {
+        int victim = -1;
+        for (int frame = frames.oldest(); frame != -1; frame = frames.next(frame)) {
+            uint8_t referenced = frames.test_and_clear_referenced(frame) ? 0x80 : 0;
+            ages[frame] = static_cast<uint8_t>((ages[frame] >> 1) | referenced);
+            if (victim == -1 || ages[frame] < ages[victim]) victim = frame;
+        }
+        return victim;
+    }
+
+private:
+    std::vector<uint8_t> ages;
+};
+
+// WSClock: a frame referenced within the last window page faults is in its
+// process's working set and is kept. The first clean frame outside every working
+// set is evicted; dirty ones passed on the way are written back, a few per turn,
+// so a later turn can evict them clean. If a full turn finds nothing, the first
+// frame cleaned is evicted, or failing that any clean frame, or the oldest.
+class WsClockPolicy : public ReplacementPolicy {
+public:
+    static const int MAX_WRITE_BACKS_PER_TURN = 4;
+
+    explicit WsClockPolicy(int num_frames) : last_use(num_frames, 0), window(std::max(1, num_frames / 8)) {}
+
+    const char* name() const override { return "wsclock"; }
+    void on_load(ResidentFrames& frames, int frame) override { last_use[frame] = frames.now(); }
+    int choose_victim(ResidentFrames& frames) override {
+        uint64_t now = frames.now();
+        int cleaned = -1, clean = -1, write_backs = 0;
+        for (int i = frames.size(); i > 0; --i) {
+            int frame = frames.oldest();
+            if (frames.test_and_clear_referenced(frame)) {
+                last_use[frame] = now;
+            } else if (now - last_use[frame] > window) {
+                if (!frames.is_dirty(frame)) return frame;
+                if (write_backs < MAX_WRITE_BACKS_PER_TURN) {
+                    frames.write_back(frame);
+                    write_backs++;
+                    if (cleaned == -1) cleaned = frame;
+                }
+            } else if (clean == -1 && !frames.is_dirty(frame)) {
+                clean = frame;
+            }
+            frames.requeue(frame);
+        }
+        if (cleaned != -1) return cleaned;
+        if (clean != -1) return clean;
+        return frames.oldest();
+    }
+
+private:
+    std::vector<uint64_t> last_use;
+    uint64_t window;
+};
+
+}
+
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(ReplacementKind kind, int num_frames) {
+    switch (kind) {
+        case ReplacementKind::CLOCK: return std::make_unique<ClockPolicy>();
+        case ReplacementKind::SECOND_CHANCE: return std::make_unique<SecondChancePolicy>();
+        case ReplacementKind::LRU: return std::make_unique<AgingPolicy>(num_frames);
+        case ReplacementKind::WSCLOCK: return std::make_unique<WsClockPolicy>(num_frames);
+        default: return std::make_unique<FifoPolicy>();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+enum class ReplacementKind { FIFO, CLOCK, SECOND_CHANCE, LRU, WSCLOCK };
+
+// Accepts the config.txt spellings: fifo, clock, second-chance, lru and wsclock.
+bool parse_replacement_kind(const std::string& text, ReplacementKind& kind);
+const char* replacement_kind_name(ReplacementKind kind);
+
+class MemoryManager;
+
+// What a policy sees of physical memory while choosing a victim. Resident frames
+// are kept in one queue in load order, oldest first; a policy that gives a frame a
+// second chance requeues it at the tail, which is how a clock hand passing over it
+// is modelled. Only valid under memory_mutex, which every policy call holds.
+class ResidentFrames {
+public:
+    explicit ResidentFrames(MemoryManager& memory) : memory(memory) {}
+
+    int size() const;
+    int oldest() const;
+    int next(int frame) const;  // -1 after the newest
+    void requeue(int frame);
+
+    // Clears the frame's ACCESSED bit and reports whether it was set. TLB hits do
+    // not set the bit, so the frame's TLB entries are invalidated as well and the
+    // next access goes through the page table again.
+    bool test_and_clear_referenced(int frame);
+    bool is_referenced(int frame) const;
+    bool is_dirty(int frame) const;
+    // Writes a dirty frame to the backing store so it can later be evicted clean.
+    void write_back(int frame);
+    // Virtual time for working-set policies: page faults serviced so far.
+    uint64_t now() const;
+
+private:
+    MemoryManager& memory;
+};
+
+class ReplacementPolicy {
+public:
+    virtual ~ReplacementPolicy() = default;
+
+    virtual const char* name() const = 0;
+    // Called once a page has been loaded into the frame and queued.
+    virtual void on_load(ResidentFrames&, int) {}
+    // Only called when every frame is in use. The returned frame is evicted.
+    virtual int choose_victim(ResidentFrames& frames) = 0;
+};
+
+std::unique_ptr<ReplacementPolicy> make_replacement_policy(ReplacementKind kind, int num_frames);
@@ -0,0 +1,92 @@
+#include "RunQueue.h"
+#include <algorithm>
+
+static bool later_deadline(const shared_ptr<Process>& a, const shared_ptr<Process>& b) {
+    if (a->absolute_deadline != b->absolute_deadline) return a->absolute_deadline > b->absolute_deadline;
+    return a->id > b->id;
+}
+
+RunQueue::RunQueue(int num_levels, bool deadline_ordered)
+    : levels(max(1, num_levels)), deadline_ordered(deadline_ordered) {}
+
+void RunQueue::push(shared_ptr<Process> process) {
+    lock_guard<mutex> lock(queue_mutex);
+    if (deadline_ordered) {
+        deadline_heap.push_back(move(process));
+        push_heap(deadline_heap.begin(), deadline_heap.end(), later_deadline);
+        heap_top_deadline = deadline_heap.front()->absolute_deadline;
+    } else {
+        int level = min(max(process->priority_level.load(), 0), static_cast<int>(levels.size()) - 1);
+        levels[level].push_back(move(process));
+    }
+    approx_size = ++queued;
+}
+
+shared_ptr<Process> RunQueue::take_front() {
+    if (deadline_ordered) {
+        if (deadline_heap.empty()) return nullptr;
+        pop_heap(deadline_heap.begin(), deadline_heap.end(), later_deadline);
+        auto process = move(deadline_heap.back());
+        deadline_heap.pop_back();
+        heap_top_deadline = deadline_heap.empty() ? NO_DEADLINE : deadline_heap.front()->absolute_deadline;
+        approx_size = --queued;
+        return process;
+    }
+    for (auto& level : levels) {
+        if (level.empty()) continue;
+        auto process = move(level.front());
+        level.pop_front();
+        approx_size = --queued;
+        return process;
+    }
+    return nullptr;
+}
+
+shared_ptr<Process> RunQueue::pop() {
+    if (approx_size.load() == 0) return nullptr;
+    lock_guard<mutex> lock(queue_mutex);
+    return take_front();
+}
+
+shared_ptr<Process> RunQueue::steal() {
+    if (approx_size.load() == 0) return nullptr;
+    unique_lock<mutex> lock(queue_mutex, try_to_lock);
+    if (!lock.owns_lock()) return nullptr;
+    return take_front();
+}
+
+void RunQueue::boost() {
+    lock_guard<mutex> lock(queue_mutex);
+    for (size_t i = 1; i < levels.size(); ++i) {
+        for (auto& process : levels[i]) {
+            process->priority_level = 0;
+            levels[0].push_back(move(process));
+        }
+        levels[i].clear();
+    }
+}
+
+// Returns true when the wait ended because work arrived.
+bool RunQueue::wait_for_work(const atomic<bool>& is_running, const atomic<bool>& is_shutting_down, chrono::milliseconds timeout) {
+    unique_lock<mutex> lock(queue_mutex);
+    idle = true;
+    bool has_work = cv.wait_for(lock, timeout, [&] { return (is_running.load() && (queued > 0 || steal_requested)) || is_shutting_down.load(); });
+    idle = false;
+    has_work = has_work && (queued > 0 || steal_requested);
+    steal_requested = false;
+    return has_work;
+}
+
+void RunQueue::notify() {
+    { lock_guard<mutex> lock(queue_mutex); }
+    cv.notify_one();
+}
+
+void RunQueue::wake_to_steal() {
+    { lock_guard<mutex> lock(queue_mutex); steal_requested = true; }
+    cv.notify_one();
+}
+
+size_t RunQueue::size() const { return approx_size.load(); }
+bool RunQueue::is_idle() const { return idle.load(); }
+int RunQueue::earliest_deadline() const { return heap_top_deadline.load(); }
@@ -0,0 +1,53 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Process.h"
+
+using namespace std;
+
+// Per-core ready queue. The owning core pops from the front; idle cores steal
+// from the front as well so the oldest waiting process is always served first.
+// Each priority level has its own deque and lower levels are always served first
+// (a single level for FCFS/RR, one per MLFQ level). Under EDF the queue is instead
+// a binary heap ordered by absolute deadline.
+class alignas(64) RunQueue {
+public:
+    explicit RunQueue(int num_levels = 1, bool deadline_ordered = false);
+
+    void push(shared_ptr<Process> process);
+    shared_ptr<Process> pop();
+    shared_ptr<Process> steal();
+    void boost();
+
+    bool wait_for_work(const atomic<bool>& is_running, const atomic<bool>& is_shutting_down, chrono::milliseconds timeout);
+    void notify();
+    // Wakes the core waiting on this queue so it looks for work to steal.
+    void wake_to_steal();
+
+    size_t size() const;
+    bool is_idle() const;
+    int earliest_deadline() const;
+
+    atomic<int> running_deadline{NO_DEADLINE};
+
+private:
+    shared_ptr<Process> take_front();
+
+    vector<deque<shared_ptr<Process>>> levels;
+    bool deadline_ordered;
+    vector<shared_ptr<Process>> deadline_heap;
+    atomic<int> heap_top_deadline{NO_DEADLINE};
+    size_t queued = 0;
+    atomic<size_t> approx_size{0};
+    atomic<bool> idle{false};
+    bool steal_requested = false;
+
+    mutable mutex queue_mutex;
+    condition_variable cv;
+};
@@ -1,9 +1,12 @@
 #include "Scheduler.h"
 #include "MemoryManager.h"
+#include "Platform.h"
 #include <random>
 #include <iostream>
 #include <chrono>
 #include <cmath>
+#include <algorithm>
+#include <utility>
 
 Scheduler::Scheduler() = default;
 
@@ -11,11 +14,38 @@ Scheduler::~Scheduler() {
     shutdown();
 }
 
-void Scheduler::initialize(const Config& cfg) {
+void Scheduler::initialize(const Config& cfg, bool lockstep) {
     if (is_initialized) return;
     config = cfg;
+    is_lockstep = lockstep;
+    if (config.scheduler == SchedulingAlgorithm::MLFQ) {
+        config.mlfq_levels = max(1, config.mlfq_levels);
+        config.mlfq_quanta.resize(config.mlfq_levels, 0);
+        for (int level = 0; level < config.mlfq_levels; ++level) {
+            if (config.mlfq_quanta[level] > 0) continue;
+            config.mlfq_quanta[level] = (level == 0) ? max(1, config.quantum_cycles) : config.mlfq_quanta[level - 1] * 2;
+        }
+    }
     is_initialized = true;
-    memory_manager = make_unique<MemoryManager>(config.max_overall_mem, config.mem_per_frame);
+    memory_manager = make_unique<MemoryManager>(config.max_overall_mem, config.mem_per_frame, config.page_replacement);
+    // Lockstep mode services faults inline so the schedule stays deterministic.
+    pager = make_unique<Pager>(memory_manager.get(), config.mem_per_frame, is_lockstep ? 0 : max(1, config.pager_threads),
+                               [this](shared_ptr<Process> process) {
+                                   lock_guard<mutex> lock(page_fault_mutex);
+                                   page_fault_wait_queue.push(move(process));
+                               });
+    if (config.archive_logs) log_store = make_unique<LogStore>("csopesy-process-logs.dat");
+    uint64_t seed = (config.seed != 0) ? config.seed : random_device{}();
+    workload_generator = make_unique<WorkloadGenerator>(config, seed, config.generator_threads, 64);
+    core_counters = vector<CoreCounters>(config.num_cpu);
+    for (int i = 0; i < config.num_cpu; ++i) {
+        run_queues.push_back(make_unique<RunQueue>(config.scheduler == SchedulingAlgorithm::MLFQ ? config.mlfq_levels : 1,
+                                                   config.scheduler == SchedulingAlgorithm::EDF));
+    }
+    if (is_lockstep) {
+        core_slices.resize(config.num_cpu);
+        return;
+    }
     scheduler_thread_handle = thread(&Scheduler::main_scheduler_loop, this);
     for (int i = 0; i < config.num_cpu; ++i) {
         worker_threads.emplace_back(&Scheduler::worker_thread_loop, this, i);
@@ -25,19 +55,25 @@ void Scheduler::initialize(const Config& cfg) {
 void Scheduler::shutdown() {
     if (!is_shutting_down.exchange(true)) {
         stop_process_generation();
-        cv.notify_all();
+        for (auto& run_queue : run_queues) run_queue->notify();
         if (scheduler_thread_handle.joinable()) scheduler_thread_handle.join();
         for (auto& t : worker_threads) {
             if (t.joinable()) t.join();
         }
         if (process_generator_thread_handle.joinable()) process_generator_thread_handle.join();
+        if (workload_generator) workload_generator->stop();
+        if (pager) pager->stop();
     }
 }
 
 void Scheduler::start_process_generation() {
     if (generate_processes.exchange(true)) return;
-    is_scheduler_running = true;
-    cv.notify_all();
+    if (!is_scheduler_running.exchange(true)) scheduler_start_time = chrono::steady_clock::now();
+    for (auto& run_queue : run_queues) run_queue->notify();
+    if (is_lockstep) {
+        next_generation_tick = cpu_tick.load() + config.batch_process_freq;
+        return;
+    }
     if (process_generator_thread_handle.joinable()) process_generator_thread_handle.join();
     process_generator_thread_handle = thread(&Scheduler::process_generator_loop, this);
 }
@@ -46,216 +82,480 @@ void Scheduler::stop_process_generation() {
     generate_processes = false;
 }
 
-void Scheduler::add_new_process(const string& name, int memory_size, optional<vector<Instruction>> instructions_opt) {
-    vector<Instruction> final_instructions;
-    size_t total_instruction_count = 0;
+bool Scheduler::add_new_process(const string& name, int memory_size, const optional<vector<Instruction>>& instructions_opt, int deadline_ticks) {
+    if (instructions_opt) return admit_process(name, memory_size, *instructions_opt, deadline_ticks);
+    GeneratedProgram program = workload_generator->take(memory_size);
+    return admit_process(name, memory_size, program.instructions, deadline_ticks);
+}
 
-    if (instructions_opt) {
-        final_instructions = *instructions_opt;
-        total_instruction_count = final_instructions.size();
-    } else {
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<> instr_dist(config.min_ins, config.max_ins);
-        
-        int instruction_target = instr_dist(gen);
-        int potential_total = 0;
-        vector<string> declared_vars;
-        final_instructions = generate_instructions(instruction_target, declared_vars, 0, potential_total);
-        total_instruction_count = potential_total;
+void Scheduler::spawn_random_processes(int count) {
+    for (int i = 0; i < count && !is_shutting_down; ++i) {
+        GeneratedProgram program = workload_generator->take();
+        admit_process("", program.memory_size, program.instructions, -1);
     }
+}
 
+// An empty name gets the generated default "p<pid>", with a suffix if a screen
+// already took that name. Returns false if a given name is already taken.
+// Programs are compiled to bytecode here and interned, so processes running the same
+// program share its image; the Instruction tree is not kept.
+bool Scheduler::admit_process(const string& name, int memory_size, const vector<Instruction>& instructions, int deadline_ticks) {
     auto now = time(nullptr);
     tm localTime;
     localtime_s(&localTime, &now);
     char buffer[100];
     strftime(buffer, sizeof(buffer), "%m/%d/%Y, %I:%M:%S %p", &localTime);
     
-    auto new_proc = make_shared<Process>(next_pid++, name, move(final_instructions), total_instruction_count, string(buffer));
-    
+    int pid = next_pid++;
+    auto new_proc = make_shared<Process>(pid, name.empty() ? "p" + to_string(pid) : name, program_images.intern(compile_program(instructions)), string(buffer));
+    new_proc->logs = LogRing(config.log_capacity);
+    new_proc->stream_logs = log_store != nullptr;
+
     new_proc->memory_size = memory_size;
+    new_proc->mark_arrival(cpu_tick.load());
+    if (deadline_ticks >= 0) new_proc->absolute_deadline = cpu_tick.load() + deadline_ticks;
+    for (int suffix = 2; !registry.add(new_proc); ++suffix) {
+        if (!name.empty()) return false;
+        new_proc->name = "p" + to_string(pid) + "-" + to_string(suffix);
+    }
     memory_manager->create_virtual_memory_for_process(new_proc);
+    enqueue_process(new_proc);
+    return true;
+}
 
-    {
-        lock_guard<mutex> lock(process_list_mutex);
-        all_processes.push_back(new_proc);
+// Returns the core whose queue received the process.
+int Scheduler::enqueue_process(shared_ptr<Process> process) {
+    set_process_state(*process, ProcessState::READY);
+    int num_queues = static_cast<int>(run_queues.size());
+    int target = -1;
+    for (int i = 0; i < num_queues; ++i) {
+        RunQueue& run_queue = *run_queues[i];
+        if (run_queue.is_idle() && run_queue.size() == 0) { target = i; break; }
+        if (target == -1 || run_queue.size() < run_queues[target]->size()) target = i;
     }
-    {
-        lock_guard<mutex> lock(queue_mutex);
-        ready_queue.push(new_proc);
+    if (config.scheduler == SchedulingAlgorithm::EDF && !run_queues[target]->is_idle()) {
+        // No idle core: hand the process to the core running the latest deadline so
+        // that core preempts in favour of it if its deadline is earlier.
+        for (int i = 0; i < num_queues; ++i) {
+            if (run_queues[i]->running_deadline.load() > run_queues[target]->running_deadline.load()) target = i;
+        }
+    }
+    run_queues[target]->push(move(process));
+    run_queues[target]->notify();
+    return target;
+}
+
+static void record_latency(LatencyMetric& metric, const ElapsedTime& elapsed) {
+    metric.ticks.record(elapsed.ticks);
+    metric.wall_us.record(static_cast<uint64_t>(elapsed.wall_ms * 1000.0));
+}
+
+void Scheduler::set_process_state(Process& process, ProcessState state) {
+    int tick = cpu_tick.load();
+    if (process.transition_to(state, tick)) {
+        record_latency(latency_stats.response, process.get_response_time());
+    }
+    if (state == ProcessState::FINISHED) {
+        registry.mark_finished(process.id);
+        record_latency(latency_stats.wait, process.get_time_in_state(ProcessState::READY, tick));
+        record_latency(latency_stats.turnaround, process.get_turnaround_time());
+    }
+}
+
+// Finished and MEM_FAULT processes keep only their summary fields, timings and the
+// last few log records; their program, symbol table and TLB are released from host
+// memory.
+void Scheduler::retire_process(const shared_ptr<Process>& process) {
+    memory_manager->release_memory_for_process(process);
+    if (log_store) log_store->seal(process->id);
+    process->release_execution_state();
+}
+
+int Scheduler::quantum_for(const Process& process) const {
+    switch (config.scheduler) {
+        case SchedulingAlgorithm::RR: return config.quantum_cycles;
+        case SchedulingAlgorithm::MLFQ: return config.mlfq_quanta[min(max(process.priority_level.load(), 0), config.mlfq_levels - 1)];
+        case SchedulingAlgorithm::EDF:
+        default: return -1;
+    }
+}
+
+// MLFQ: a process that burns its whole quantum drops a level; one that gives up the
+// core early to sleep or wait on a page fault is treated as interactive and moves up.
+void Scheduler::update_priority_level(Process& process, bool used_full_quantum) {
+    int level = process.priority_level.load();
+    if (used_full_quantum) {
+        process.priority_level = min(level + 1, config.mlfq_levels - 1);
+    } else if (level > 0) {
+        process.priority_level = level - 1;
+    }
+}
+
+void Scheduler::boost_priority_levels() {
+    if (config.scheduler != SchedulingAlgorithm::MLFQ || config.mlfq_boost_period <= 0) return;
+    int now = cpu_tick.load();
+    if (now < last_boost_tick + config.mlfq_boost_period) return;
+    last_boost_tick = now;
+    for (auto& proc : get_running_processes()) proc->priority_level = 0;
+    for (auto& run_queue : run_queues) run_queue->boost();
+}
+
+shared_ptr<Process> Scheduler::steal_process(int core_id) {
+    int num_queues = static_cast<int>(run_queues.size());
+    for (int i = 1; i < num_queues; ++i) {
+        RunQueue& victim = *run_queues[(core_id + i) % num_queues];
+        if (victim.size() == 0) continue;
+        if (auto process = victim.steal()) {
+            core_counters[core_id].steals++;
+            return process;
+        }
+    }
+    return nullptr;
+}
+
+void Scheduler::wake_idle_core(int core_id) {
+    int num_queues = static_cast<int>(run_queues.size());
+    for (int i = 1; i < num_queues; ++i) {
+        RunQueue& sibling = *run_queues[(core_id + i) % num_queues];
+        if (sibling.is_idle()) { sibling.wake_to_steal(); return; }
     }
-    cv.notify_one();
 }
 
 void Scheduler::main_scheduler_loop() {
     while (!is_shutting_down) {
+        if (is_scheduler_running.load() && config.virtual_clock) {
+            advance_virtual_clock();
+            continue;
+        }
         if (is_scheduler_running.load()) {
             cpu_tick++;
-            {
-                lock_guard<mutex> lock(page_fault_mutex);
-                while (!page_fault_wait_queue.empty()) {
-                    auto proc = page_fault_wait_queue.front();
-                    page_fault_wait_queue.pop();
-                    lock_guard<mutex> ready_lock(queue_mutex);
-                    ready_queue.push(proc);
-                }
-            }
-            cv.notify_all();
+            boost_priority_levels();
+            release_sleeping_processes();
+            release_page_faulted_processes();
         }
         this_thread::sleep_for(chrono::milliseconds(100));
     }
 }
 
+// Lockstep mode: one call performs the tick thread's work for a tick, admits a
+// generator batch when one is due, then lets every core execute one instruction in
+// core order. Nothing depends on thread timing, so a fixed seed replays exactly.
+void Scheduler::run_tick() {
+    if (!is_lockstep || !is_scheduler_running.load()) return;
+    cpu_tick++;
+    boost_priority_levels();
+    release_sleeping_processes();
+    release_page_faulted_processes();
+    if (generate_processes.load() && config.batch_process_freq > 0 && cpu_tick.load() >= next_generation_tick.load()) {
+        spawn_random_processes(max(1, config.batch_process_size));
+        next_generation_tick = cpu_tick.load() + config.batch_process_freq;
+    }
+    for (int core_id = 0; core_id < config.num_cpu; ++core_id) {
+        CoreSlice& slice = core_slices[core_id];
+        if (!slice.process) slice = dispatch_process(core_id);
+        if (!slice.process) continue;
+        if (!step_slice(core_id, slice, 1)) end_slice(core_id, slice);
+        else if (slice.process->unflushed_logs.size() >= LogStore::SEGMENT_RECORDS) flush_logs(*slice.process);
+    }
+}
+
+bool Scheduler::is_running() const {
+    return is_scheduler_running.load();
+}
+
+bool Scheduler::is_generating() const {
+    return generate_processes.load();
+}
+
+void Scheduler::release_sleeping_processes() {
+    for (auto& proc : sleep_wheel.advance(cpu_tick.load())) {
+        core_counters[enqueue_process(proc)].requeues++;
+    }
+}
+
+void Scheduler::release_page_faulted_processes() {
+    lock_guard<mutex> lock(page_fault_mutex);
+    while (!page_fault_wait_queue.empty()) {
+        auto proc = page_fault_wait_queue.front();
+        page_fault_wait_queue.pop();
+        core_counters[enqueue_process(proc)].requeues++;
+    }
+}
+
+// Virtual clock: a tick passes once the cores have executed num_cpu instructions
+// between them. When nothing has executed for a short host interval every core is
+// idle or blocked, so the clock jumps straight to the next pending event.
+void Scheduler::advance_virtual_clock() {
+    static const auto stall_interval = chrono::milliseconds(1);
+    uint64_t executed_at_tick = executed_instructions();
+    auto tick_started = chrono::steady_clock::now();
+
+    while (!is_shutting_down && is_scheduler_running.load()) {
+        bool generator_pending = generate_processes.load() && next_generation_tick.load() <= cpu_tick.load();
+        uint64_t executed = executed_instructions() - executed_at_tick;
+        if (executed >= static_cast<uint64_t>(config.num_cpu) && !generator_pending) {
+            cpu_tick++;
+            break;
+        }
+        if (chrono::steady_clock::now() - tick_started < stall_interval) {
+            this_thread::yield();
+            continue;
+        }
+        if (generator_pending) {
+            this_thread::sleep_for(chrono::microseconds(100));
+            continue;
+        }
+        if (executed > 0) {
+            cpu_tick++;
+            break;
+        }
+        int next_tick = next_event_tick();
+        if (next_tick > cpu_tick.load()) {
+            cpu_tick = next_tick;
+            break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(1));
+        tick_started = chrono::steady_clock::now();
+    }
+    boost_priority_levels();
+    release_sleeping_processes();
+    release_page_faulted_processes();
+}
+
+int Scheduler::next_event_tick() {
+    int now = cpu_tick.load();
+    int next_tick = -1;
+    auto consider = [&](int tick) {
+        if (tick > now && (next_tick == -1 || tick < next_tick)) next_tick = tick;
+    };
+    {
+        lock_guard<mutex> lock(page_fault_mutex);
+        if (!page_fault_wait_queue.empty()) consider(now + 1);
+    }
+    if (pager->is_busy()) consider(now + 1);
+    if (generate_processes.load()) consider(next_generation_tick.load());
+    consider(sleep_wheel.next_expiry());
+    return next_tick;
+}
+
+void Scheduler::wait_for_ticks(int ticks) {
+    if (!config.virtual_clock) {
+        for (int i = 0; i < ticks && generate_processes; ++i) {
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+        return;
+    }
+    int target_tick = cpu_tick.load() + ticks;
+    next_generation_tick = target_tick;
+    while (cpu_tick.load() < target_tick && generate_processes && !is_shutting_down) {
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+}
+
 void Scheduler::process_generator_loop() {
     if (config.batch_process_freq <= 0) return;
-    random_device rd;
-    mt19937 gen(rd());
     while (generate_processes && !is_shutting_down) {
-        int wait_ticks = config.batch_process_freq;
-        for(int i = 0; i < wait_ticks && generate_processes; ++i) {
-            this_thread::sleep_for(chrono::milliseconds(100)); 
-        }
+        wait_for_ticks(config.batch_process_freq);
         if (generate_processes) {
-            string proc_name = "p" + to_string(next_pid);
-            uniform_int_distribution<> mem_dist(config.min_mem_per_proc, config.max_mem_per_proc);
-            int random_mem = mem_dist(gen);
-            int mem_size = pow(2, floor(log2(random_mem)));
-            add_new_process(proc_name, mem_size, nullopt);
+            spawn_random_processes(max(1, config.batch_process_size));
         }
     }
 }
 
 void Scheduler::worker_thread_loop(int core_id) {
     while (!is_shutting_down) {
-       shared_ptr<Process> current_process;
-        {
-            unique_lock<mutex> lock(queue_mutex);
-            cv.wait(lock, [this] { return (is_scheduler_running.load() && !ready_queue.empty()) || is_shutting_down.load(); });
-            if (is_shutting_down || !is_scheduler_running.load() || ready_queue.empty()) continue;
-            current_process = ready_queue.front();
-            ready_queue.pop();
-        }
-        active_process_count++;
-        current_process->core_assigned = core_id;
-        int quantum = (config.scheduler == SchedulingAlgorithm::RR) ? config.quantum_cycles : -1;
-        int instructions_executed = 0;
-        while (!current_process->is_finished.load() && !is_shutting_down) {
-            if (current_process->is_sleeping(cpu_tick.load())) break;
-            active_ticks++;
-            current_process->execute_instruction(memory_manager.get(), core_id, cpu_tick.load(), config.delay_per_exec);
-            if (current_process->needs_page_fault_handling.load()) {
-                int page_number = current_process->faulting_address.load() / config.mem_per_frame;
-                memory_manager->handle_page_fault(current_process, page_number);
-                lock_guard<mutex> lock(page_fault_mutex);
-                page_fault_wait_queue.push(current_process);
-                break;
+        CoreSlice slice;
+        if (is_scheduler_running.load()) slice = dispatch_process(core_id);
+        if (!slice.process) {
+            if (run_queues[core_id]->wait_for_work(is_scheduler_running, is_shutting_down, chrono::milliseconds(100))) {
+                core_counters[core_id].idle_wakeups++;
             }
-            instructions_executed++;
-            if (quantum != -1 && instructions_executed >= quantum) break;
+            continue;
         }
-        current_process->core_assigned = -1;
-        active_process_count--;
-        if (current_process->is_finished.load()) {
-            memory_manager->release_memory_for_process(current_process);
-        } else if (!current_process->needs_page_fault_handling.load() && !is_shutting_down) {
-            lock_guard<mutex> lock(queue_mutex);
-            ready_queue.push(current_process);
+        // Records are handed over after every batch, so a process that keeps its core
+        // (FCFS, EDF) still streams its log instead of holding it all in memory.
+        while (!is_shutting_down && step_slice(core_id, slice, slice_batch_limit(config.scheduler))) flush_logs(*slice.process);
+        end_slice(core_id, slice);
+    }
+}
+
+CoreSlice Scheduler::dispatch_process(int core_id) {
+    RunQueue& local_queue = *run_queues[core_id];
+    CoreSlice slice;
+    slice.process = local_queue.pop();
+    if (!slice.process) slice.process = steal_process(core_id);
+    if (!slice.process) return slice;
+    core_counters[core_id].dispatches++;
+    core_counters[core_id].busy = true;
+    local_queue.running_deadline = slice.process->absolute_deadline;
+    set_process_state(*slice.process, ProcessState::RUNNING);
+    slice.process->core_assigned = core_id;
+    slice.quantum = quantum_for(*slice.process);
+    return slice;
+}
+
+// Executes up to max_batch instructions of the slice in one run_slice call and
+// returns false once the slice has to end (finished, sleeping, page fault, violation,
+// quantum used up, or EDF preemption).
+bool Scheduler::step_slice(int core_id, CoreSlice& slice, size_t max_batch) {
+    const shared_ptr<Process>& current_process = slice.process;
+    size_t budget = max_batch;
+    if (slice.quantum != -1) budget = min(budget, static_cast<size_t>(slice.quantum - slice.instructions_executed));
+    slice.last = current_process->run_slice(memory_manager.get(), cpu_tick.load(), budget, config.delay_per_exec);
+    core_counters[core_id].instructions += slice.last.executed;
+    slice.instructions_executed += static_cast<int>(slice.last.executed);
+    if (slice.last.reason == StopReason::PAGE_FAULT) {
+        set_process_state(*current_process, ProcessState::FAULT_BLOCKED);
+        return false;
+    }
+    if (slice.last.reason != StopReason::QUANTUM_EXPIRED) return false;
+    if (slice.quantum != -1 && slice.instructions_executed >= slice.quantum) return false;
+    if (config.scheduler == SchedulingAlgorithm::EDF && run_queues[core_id]->earliest_deadline() < current_process->absolute_deadline) return false;
+    return true;
+}
+
+void Scheduler::flush_logs(Process& process) {
+    if (!log_store || process.unflushed_logs.empty()) return;
+    log_store->append(process.id, move(process.unflushed_logs));
+    process.unflushed_logs.clear();
+}
+
+void Scheduler::end_slice(int core_id, CoreSlice& slice) {
+    shared_ptr<Process> current_process = move(slice.process);
+    run_queues[core_id]->running_deadline = NO_DEADLINE;
+    current_process->core_assigned = -1;
+    core_counters[core_id].busy = false;
+    core_counters[core_id].tlb_hits += exchange(current_process->tlb->hits, 0);
+    core_counters[core_id].tlb_misses += exchange(current_process->tlb->misses, 0);
+    flush_logs(*current_process);
+    StopReason reason = slice.last.reason;
+    bool finished = reason == StopReason::FINISHED || reason == StopReason::VIOLATION;
+    if (config.scheduler == SchedulingAlgorithm::MLFQ && !finished) {
+        update_priority_level(*current_process, slice.instructions_executed >= slice.quantum);
+    }
+    if (finished) {
+        set_process_state(*current_process, ProcessState::FINISHED);
+        retire_process(current_process);
+    } else if (reason == StopReason::PAGE_FAULT) {
+        // Handed to the pager only once this core is done with the process, so it
+        // cannot be released and dispatched elsewhere while the slice is ending.
+        if (!is_shutting_down) pager->request(current_process, slice.last.address, slice.last.length);
+    } else if (!is_shutting_down) {
+        bool parked = false;
+        if (reason == StopReason::SLEEPING) {
+            set_process_state(*current_process, ProcessState::SLEEPING);
+            parked = sleep_wheel.schedule(current_process, slice.last.sleep_until);
         }
-        cv.notify_one();
-    }
-}
-
-vector<Instruction> Scheduler::generate_instructions(int num_instructions, vector<string>& declared_vars, int depth, int& potential_total_instructions) {
-    random_device rd;
-    mt19937 gen(rd());
-    vector<Instruction> instructions;
-    uniform_int_distribution<> type_dist(0, 9);
-    for (int i = 0; i < num_instructions; ++i) {
-        if (potential_total_instructions >= config.max_ins) break;
-        int instruction_choice = type_dist(gen);
-        bool can_generate_for = (instruction_choice == 9 && depth < 3);
-        if (can_generate_for) {
-            uniform_int_distribution<uint16_t> repeat_dist(2, 10);
-            uint16_t repeats = repeat_dist(gen);
-            uniform_int_distribution<> inner_instr_count_dist(2, 5);
-            int inner_count = inner_instr_count_dist(gen);
-            int inner_potential_total = 0;
-            vector<Instruction> inner_instructions = generate_instructions(inner_count, declared_vars, depth + 1, inner_potential_total);
-            if (!inner_instructions.empty() && (potential_total_instructions + (inner_potential_total * repeats) < config.max_ins)) {
-                Instruction for_loop_instr;
-                for_loop_instr.type = InstructionType::FOR;
-                for_loop_instr.for_block = move(inner_instructions);
-                for_loop_instr.for_repeats = repeats;
-                instructions.push_back(move(for_loop_instr));
-                potential_total_instructions += (inner_potential_total * repeats);
-            } else {
-                instructions.push_back({InstructionType::PRINT, {}});
-                potential_total_instructions++;
-            }
-        } else {
-            if (instruction_choice == 5 && declared_vars.size() < 20) {
-                string new_var_name = "v" + to_string(declared_vars.size());
-                declared_vars.push_back(new_var_name);
-                uniform_int_distribution<uint16_t> val_dist(0, 1000);
-                instructions.push_back({InstructionType::DECLARE, {new_var_name, val_dist(gen)}});
-            } else if ((instruction_choice == 6 || instruction_choice == 7) && declared_vars.size() >= 2) {
-                uniform_int_distribution<size_t> var_idx_dist(0, declared_vars.size() - 1);
-                instructions.push_back({(instruction_choice == 6 ? InstructionType::ADD : InstructionType::SUBTRACT), {declared_vars[var_idx_dist(gen)], declared_vars[var_idx_dist(gen)], declared_vars[var_idx_dist(gen)]}});
-            } else if (instruction_choice == 8) {
-                uniform_int_distribution<uint16_t> sleep_dist(5, 20);
-                instructions.push_back({InstructionType::SLEEP, {sleep_dist(gen)}});
-            } else {
-                instructions.push_back({InstructionType::PRINT, {}});
-            }
-            potential_total_instructions++;
+        if (!parked) {
+            // Still runnable without having slept: the quantum ran out or EDF preempted it.
+            if (reason != StopReason::SLEEPING) core_counters[core_id].preemptions++;
+            core_counters[core_id].requeues++;
+            set_process_state(*current_process, ProcessState::READY);
+            run_queues[core_id]->push(current_process);
+            // Anything beyond the process this core runs next can go to an idle sibling
+            // now rather than when the sibling's wait times out.
+            if (run_queues[core_id]->size() > 1) wake_idle_core(core_id);
         }
     }
-    return instructions;
 }
 
 shared_ptr<Process> Scheduler::find_process(const string& name) {
-    lock_guard<mutex> lock(process_list_mutex);
-    for (const auto& proc : all_processes) {
-        if (proc->name == name) return proc;
-    }
-    return nullptr;
+    return registry.find(name);
+}
+
+shared_ptr<Process> Scheduler::find_process(int pid) {
+    return registry.find(pid);
 }
 
 vector<shared_ptr<Process>> Scheduler::get_running_processes() {
-    vector<shared_ptr<Process>> running;
-    lock_guard<mutex> lock(process_list_mutex);
-    for (const auto& proc : all_processes) {
-        if (!proc->is_finished.load()) running.push_back(proc);
-    }
-    return running;
+    return registry.running();
 }
 
 vector<shared_ptr<Process>> Scheduler::get_finished_processes() {
-    vector<shared_ptr<Process>> finished;
-    lock_guard<mutex> lock(process_list_mutex);
-    for (const auto& proc : all_processes) {
-        if (proc->is_finished.load()) finished.push_back(proc);
-    }
-    return finished;
+    return registry.retired();
 }
 
 vector<shared_ptr<Process>> Scheduler::get_all_processes() {
-    lock_guard<mutex> lock(process_list_mutex);
-    return all_processes;
+    return registry.all();
+}
+
+size_t Scheduler::get_log_line_count(const shared_ptr<Process>& process) {
+    if (log_store) return log_store->count(process->id);
+    lock_guard<mutex> lock(process->data_mutex);
+    return process->logs.size();
 }
 
-int Scheduler::get_cores_used() {
-    return active_process_count.load();
+// Lines first..first+count of the process's log. With the log store only that range
+// is read from disk; otherwise it comes from the in-memory ring.
+vector<string> Scheduler::get_process_logs(const shared_ptr<Process>& process, size_t first, size_t count) {
+    vector<LogRecord> records;
+    if (log_store) {
+        records = log_store->read(process->id, first, count);
+    } else {
+        records = process->get_log_records();
+        if (first >= records.size()) records.clear();
+        else records = vector<LogRecord>(records.begin() + first, records.begin() + min(records.size(), first + count));
+    }
+    return process->format_log_records(records);
+}
+
+const ProcessRegistry& Scheduler::get_registry() const {
+    return registry;
 }
 
 MemoryManager* Scheduler::get_memory_manager() const {
     return memory_manager.get();
 }
 
-uint64_t Scheduler::get_total_ticks() const {
-    return cpu_tick.load() * config.num_cpu;
+const LatencyStats& Scheduler::get_latency_stats() const {
+    return latency_stats;
+}
+
+int Scheduler::get_current_tick() const {
+    return cpu_tick.load();
 }
 
-uint64_t Scheduler::get_active_ticks() const {
-    return active_ticks.load();
+uint64_t Scheduler::executed_instructions() const {
+    uint64_t total = 0;
+    for (const auto& counters : core_counters) total += counters.instructions.load(memory_order_relaxed);
+    return total;
+}
+
+MetricsSnapshot Scheduler::get_metrics() const {
+    MetricsSnapshot snapshot;
+    snapshot.num_cpu = config.num_cpu;
+    snapshot.current_tick = cpu_tick.load();
+    snapshot.total_ticks = static_cast<uint64_t>(snapshot.current_tick) * config.num_cpu;
+    for (const auto& counters : core_counters) {
+        snapshot.active_ticks += counters.instructions.load(memory_order_relaxed);
+        snapshot.dispatches += counters.dispatches.load(memory_order_relaxed);
+        snapshot.steals += counters.steals.load(memory_order_relaxed);
+        snapshot.preemptions += counters.preemptions.load(memory_order_relaxed);
+        snapshot.requeues += counters.requeues.load(memory_order_relaxed);
+        snapshot.idle_wakeups += counters.idle_wakeups.load(memory_order_relaxed);
+        snapshot.tlb_hits += counters.tlb_hits.load(memory_order_relaxed);
+        snapshot.tlb_misses += counters.tlb_misses.load(memory_order_relaxed);
+        if (counters.busy.load(memory_order_relaxed)) snapshot.cores_used++;
+    }
+    snapshot.idle_ticks = (snapshot.total_ticks > snapshot.active_ticks) ? snapshot.total_ticks - snapshot.active_ticks : 0;
+    if (is_scheduler_running.load()) {
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - scheduler_start_time).count();
+        if (elapsed > 0) snapshot.dispatches_per_sec = snapshot.dispatches / elapsed;
+    }
+
+    snapshot.running_processes = registry.running_count();
+    snapshot.finished_processes = registry.finished_count();
+    snapshot.faulted_processes = registry.faulted_count();
+    snapshot.program_images = program_images.live_images();
+
+    if (pager) {
+        const PagerStats& pager_stats = pager->get_stats();
+        snapshot.faults_serviced = pager_stats.faults_serviced.load();
+        snapshot.fault_service_mean_us = pager_stats.service_us.mean();
+        snapshot.fault_service_p99_us = pager_stats.service_us.percentile(99);
+        snapshot.pager_queue_depth = pager->queue_depth();
+        snapshot.pager_max_queue_depth = pager_stats.max_queue_depth.load();
+    }
+    if (memory_manager) snapshot.memory = memory_manager->snapshot();
+    return snapshot;
 }
\ No newline at end of file
@@ -1,6 +1,15 @@
 #pragma once
+#include "Config.h"
 #include "Process.h"
 #include "MemoryManager.h" 
+#include "RunQueue.h"
+#include "TimerWheel.h"
+#include "LatencyHistogram.h"
+#include "ProcessRegistry.h"
+#include "LogStore.h"
+#include "WorkloadGenerator.h"
+#include "Pager.h"
+#include "ProgramCache.h"
 #include <vector>
 #include <queue>
 #include <map>
@@ -12,83 +21,176 @@
 #include <random>
 #include <optional>
 #include <cstdint>
+#include <chrono>
 
 using namespace std;
 
-enum class SchedulingAlgorithm {
-    FCFS,
-    RR
+struct LatencyMetric {
+    LatencyHistogram ticks;
+    LatencyHistogram wall_us;
 };
 
-struct Config {
-    int num_cpu = 1;
-    SchedulingAlgorithm scheduler = SchedulingAlgorithm::FCFS;
-    int quantum_cycles = 10;
-    int batch_process_freq = 100;
-    int min_ins = 100;
-    int max_ins = 500;
-    int delay_per_exec = 0;
-
-    int max_overall_mem = 16384; 
-    int mem_per_frame = 256;    
-    int min_mem_per_proc = 1024;
-    int max_mem_per_proc = 4096;
+struct LatencyStats {
+    LatencyMetric wait;
+    LatencyMetric turnaround;
+    LatencyMetric response;
 };
 
+// Per-core counters, each on its own cache line so cores never bump a shared line.
+// Readers sum the shards.
+struct alignas(64) CoreCounters {
+    atomic<uint64_t> instructions{0};
+    atomic<uint64_t> dispatches{0};
+    atomic<uint64_t> steals{0};
+    atomic<uint64_t> preemptions{0};
+    atomic<uint64_t> requeues{0};
+    atomic<uint64_t> idle_wakeups{0};
+    atomic<uint64_t> tlb_hits{0};
+    atomic<uint64_t> tlb_misses{0};
+    atomic<bool> busy{false};
+};
+
+// Point-in-time view of the scheduler, pager and memory counters. Taking one never
+// locks anything the cores use.
+struct MetricsSnapshot {
+    int num_cpu = 0;
+    int current_tick = 0;
+    uint64_t total_ticks = 0;
+    uint64_t active_ticks = 0;
+    uint64_t idle_ticks = 0;
+    int cores_used = 0;
+
+    uint64_t dispatches = 0;
+    uint64_t steals = 0;
+    uint64_t preemptions = 0;
+    uint64_t requeues = 0;
+    uint64_t idle_wakeups = 0;
+    double dispatches_per_sec = 0.0;
+    uint64_t tlb_hits = 0;
+    uint64_t tlb_misses = 0;
+
+    size_t running_processes = 0;
+    size_t finished_processes = 0;
+    size_t faulted_processes = 0;
+    size_t program_images = 0;
+
+    uint64_t faults_serviced = 0;
+    double fault_service_mean_us = 0.0;
+    uint64_t fault_service_p99_us = 0;
+    size_t pager_queue_depth = 0;
+    size_t pager_max_queue_depth = 0;
+
+    MemorySnapshot memory;
+};
+
+struct CoreSlice {
+    shared_ptr<Process> process;
+    int quantum = -1;
+    int instructions_executed = 0;
+    SliceResult last;
+};
+
+// Longest run of instructions a worker executes without coming back to the
+// scheduler, so shutdown is noticed and logs are handed over on an unbounded
+// quantum. EDF uses shorter batches; see slice_batch_limit.
+const size_t MAX_SLICE_BATCH = 1024;
+
+// EDF looks for an earlier deadline between batches, so its batches are a single
+// instruction and a waiting process preempts the running one after its current
+// instruction, not up to MAX_SLICE_BATCH instructions later.
+inline size_t slice_batch_limit(SchedulingAlgorithm algorithm) {
+    return algorithm == SchedulingAlgorithm::EDF ? 1 : MAX_SLICE_BATCH;
+}
+
 class Scheduler {
 public:
     Scheduler();
     ~Scheduler();
 
-    void initialize(const Config& cfg);
+    void initialize(const Config& cfg, bool lockstep = false);
+    void run_tick();
+    bool is_running() const;
+    bool is_generating() const;
     void start_process_generation();
     void stop_process_generation();
     
-    void add_new_process(const string& name, int memory_size, optional<vector<Instruction>> instructions_opt);
+    bool add_new_process(const string& name, int memory_size, const optional<vector<Instruction>>& instructions_opt, int deadline_ticks = -1);
+    void spawn_random_processes(int count);
     
     shared_ptr<Process> find_process(const string& name);
+    shared_ptr<Process> find_process(int pid);
     vector<shared_ptr<Process>> get_running_processes();
     vector<shared_ptr<Process>> get_finished_processes();
     vector<shared_ptr<Process>> get_all_processes();
-    int get_cores_used();
+    const ProcessRegistry& get_registry() const;
+    size_t get_log_line_count(const shared_ptr<Process>& process);
+    vector<string> get_process_logs(const shared_ptr<Process>& process, size_t first, size_t count);
     
     MemoryManager* get_memory_manager() const;
     void shutdown();
 
-    uint64_t get_total_ticks() const;
-    uint64_t get_active_ticks() const;
+    int get_current_tick() const;
+    MetricsSnapshot get_metrics() const;
+    const LatencyStats& get_latency_stats() const;
 
 private:
     void worker_thread_loop(int core_id);
+    CoreSlice dispatch_process(int core_id);
+    bool step_slice(int core_id, CoreSlice& slice, size_t max_batch);
+    void end_slice(int core_id, CoreSlice& slice);
+    void flush_logs(Process& process);
     void process_generator_loop();
     void main_scheduler_loop();
-    vector<Instruction> generate_instructions(int num_instructions, vector<string>& declared_vars, int depth, int& potential_total_instructions);
+    void release_page_faulted_processes();
+    void release_sleeping_processes();
+    void advance_virtual_clock();
+    int next_event_tick();
+    void wait_for_ticks(int ticks);
+    int enqueue_process(shared_ptr<Process> process);
+    uint64_t executed_instructions() const;
+    void set_process_state(Process& process, ProcessState state);
+    void retire_process(const shared_ptr<Process>& process);
+    int quantum_for(const Process& process) const;
+    void update_priority_level(Process& process, bool used_full_quantum);
+    void boost_priority_levels();
+    shared_ptr<Process> steal_process(int core_id);
+    void wake_idle_core(int core_id);
+    bool admit_process(const string& name, int memory_size, const vector<Instruction>& instructions, int deadline_ticks);
         
     Config config;
     atomic<bool> is_initialized{false};
+    bool is_lockstep = false;
+    vector<CoreSlice> core_slices;
     atomic<bool> is_shutting_down{false};
     atomic<bool> generate_processes{false};
     
     atomic<bool> is_scheduler_running{false};
-    atomic<int> active_process_count{0};
-    atomic<int> next_pid{1};
+    alignas(64) atomic<int> next_pid{1};
 
-    atomic<int> cpu_tick{0};
-    atomic<uint64_t> active_ticks{0};
+    // Written only by the tick thread but read on every instruction, so it gets its
+    // own cache line.
+    alignas(64) atomic<int> cpu_tick{0};
+    alignas(64) atomic<int> next_generation_tick{-1};
+    int last_boost_tick = 0;
+    vector<CoreCounters> core_counters;
+    chrono::steady_clock::time_point scheduler_start_time;
 
     vector<thread> worker_threads;
     thread process_generator_thread_handle;
     thread scheduler_thread_handle;
 
-    queue<shared_ptr<Process>> ready_queue;
-    vector<shared_ptr<Process>> all_processes;
+    vector<unique_ptr<RunQueue>> run_queues;
+    TimerWheel sleep_wheel;
+    ProcessRegistry registry;
+    ProgramImageCache program_images;
 
     queue<shared_ptr<Process>> page_fault_wait_queue; 
     mutex page_fault_mutex;
 
     unique_ptr<MemoryManager> memory_manager;
+    LatencyStats latency_stats;
+    unique_ptr<LogStore> log_store;
+    unique_ptr<WorkloadGenerator> workload_generator;
+    unique_ptr<Pager> pager;
 
-    mutex queue_mutex;
-    mutex process_list_mutex;
-    condition_variable cv;
 };
\ No newline at end of file
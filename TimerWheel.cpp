@@ -0,0 +1,77 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+bool TimerWheel::schedule(shared_ptr<Process> process, int wake_tick) {
+    lock_guard<mutex> lock(wheel_mutex);
+    if (wake_tick <= current_tick) return false;
+    insert({wake_tick, move(process)});
+    entry_count++;
+    return true;
+}
+
+void TimerWheel::insert(Entry&& entry) {
+    for (int level = 0; level < LEVELS; ++level) {
+        int upper_shift = SLOT_BITS * (level + 1);
+        if ((entry.wake_tick >> upper_shift) == (current_tick >> upper_shift)) {
+            int slot = (entry.wake_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+            wheel[level][slot].push_back(move(entry));
+            return;
+        }
+    }
+    overflow.push_back(move(entry));
+}
+
+void TimerWheel::cascade(int level) {
+    vector<Entry> entries;
+    if (level == LEVELS) {
+        entries.swap(overflow);
+    } else {
+        int slot = (current_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+        entries.swap(wheel[level][slot]);
+    }
+    for (auto& entry : entries) insert(move(entry));
+}
+
+vector<shared_ptr<Process>> TimerWheel::advance(int to_tick) {
+    vector<shared_ptr<Process>> woken;
+    lock_guard<mutex> lock(wheel_mutex);
+    if (entry_count == 0) {
+        current_tick = max(current_tick, to_tick);
+        return woken;
+    }
+    while (current_tick < to_tick) {
+        current_tick++;
+        for (int level = LEVELS; level >= 1; --level) {
+            if ((current_tick & ((1 << (SLOT_BITS * level)) - 1)) == 0) cascade(level);
+        }
+        auto& expired = wheel[0][current_tick & (SLOTS - 1)];
+        for (auto& entry : expired) woken.push_back(move(entry.process));
+        entry_count -= expired.size();
+        expired.clear();
+        if (entry_count == 0) current_tick = to_tick;
+    }
+    return woken;
+}
+
+int TimerWheel::next_expiry() const {
+    lock_guard<mutex> lock(wheel_mutex);
+    if (entry_count == 0) return -1;
+    for (int level = 0; level < LEVELS; ++level) {
+        int start_slot = (current_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+        for (int slot = start_slot; slot < SLOTS; ++slot) {
+            const auto& entries = wheel[level][slot];
+            if (entries.empty()) continue;
+            int earliest = entries.front().wake_tick;
+            for (const auto& entry : entries) earliest = min(earliest, entry.wake_tick);
+            return earliest;
+        }
+    }
+    int earliest = overflow.front().wake_tick;
+    for (const auto& entry : overflow) earliest = min(earliest, entry.wake_tick);
+    return earliest;
+}
+
+size_t TimerWheel::size() const {
+    lock_guard<mutex> lock(wheel_mutex);
+    return entry_count;
+}
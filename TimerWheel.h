@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <mutex>
+#include <memory>
+#include "Process.h"
+
+using namespace std;
+
+// Hierarchical timer wheel holding sleeping processes until their wake-up tick.
+// Level k covers ticks that differ from the current tick only in the k-th group
+// of SLOT_BITS bits; entries cascade down a level each time that group rolls over.
+class TimerWheel {
+public:
+    bool schedule(shared_ptr<Process> process, int wake_tick);
+    vector<shared_ptr<Process>> advance(int to_tick);
+    int next_expiry() const;
+    size_t size() const;
+
+private:
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const int LEVELS = 4;
+
+    struct Entry {
+        int wake_tick;
+        shared_ptr<Process> process;
+    };
+
+    void insert(Entry&& entry);
+    void cascade(int level);
+
+    array<array<vector<Entry>, SLOTS>, LEVELS> wheel;
+    vector<Entry> overflow;
+    int current_tick = 0;
+    size_t entry_count = 0;
+
+    mutable mutex wheel_mutex;
+};
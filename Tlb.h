@@ -0,0 +1,29 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+struct PageTableEntry;
+
+struct TlbEntry {
+    int page = -1;
+    int frame = -1;
+    uint32_t generation = 0;
+    PageTableEntry* pte = nullptr;
+};
+
+// Direct-mapped software TLB owned by a process and only touched by the core
+// executing it. An entry is valid while its frame's generation in the memory
+// manager still matches; eviction and release bump the generation instead of
+// reaching into every process's TLB. Hit and miss counts are harvested by the
+// scheduler at the end of each slice.
+struct Tlb {
+    static const int SIZE = 16;
+
+    array<TlbEntry, SIZE> entries;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    TlbEntry& slot(int page) { return entries[page & (SIZE - 1)]; }
+};
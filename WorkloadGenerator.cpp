@@ -0,0 +1,176 @@
+#include "WorkloadGenerator.h"
+#include "Bytecode.h"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed) {
+    for (auto& word : state) word = splitmix64(seed);
+}
+
+Xoshiro256::result_type Xoshiro256::operator()() {
+    uint64_t result = rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+}
+
+WorkloadGenerator::WorkloadGenerator(const Config& cfg, uint64_t seed, int num_threads, size_t capacity)
+    : config(cfg), base_seed(seed), buffer_capacity(max<size_t>(1, capacity)) {
+    for (int i = 0; i < max(1, num_threads); ++i) {
+        generator_threads.emplace_back(&WorkloadGenerator::worker_loop, this);
+    }
+}
+
+WorkloadGenerator::~WorkloadGenerator() {
+    stop();
+}
+
+void WorkloadGenerator::stop() {
+    {
+        lock_guard<mutex> lock(buffer_mutex);
+        if (is_stopping) return;
+        is_stopping = true;
+    }
+    space_available.notify_all();
+    program_ready.notify_all();
+    for (auto& t : generator_threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+GeneratedProgram WorkloadGenerator::take(int memory_size) {
+    uint64_t sequence;
+    GeneratedProgram program;
+    {
+        unique_lock<mutex> lock(buffer_mutex);
+        program_ready.wait(lock, [this] { return ready_programs.count(next_to_take) || is_stopping; });
+        sequence = next_to_take++;
+        auto it = ready_programs.find(sequence);
+        if (it == ready_programs.end()) return generate_program(sequence, memory_size);
+        program = move(it->second);
+        ready_programs.erase(it);
+    }
+    space_available.notify_one();
+    if (memory_size > 0 && memory_size != program.memory_size) program = generate_program(sequence, memory_size);
+    return program;
+}
+
+void WorkloadGenerator::worker_loop() {
+    while (true) {
+        uint64_t sequence;
+        {
+            unique_lock<mutex> lock(buffer_mutex);
+            space_available.wait(lock, [this] { return next_to_generate - next_to_take < buffer_capacity || is_stopping; });
+            if (is_stopping) return;
+            sequence = next_to_generate++;
+        }
+        GeneratedProgram program = generate_program(sequence);
+        {
+            lock_guard<mutex> lock(buffer_mutex);
+            ready_programs.emplace(sequence, move(program));
+        }
+        program_ready.notify_all();
+    }
+}
+
+// The memory size is drawn first, or given, so block instructions can be kept
+// inside it.
+GeneratedProgram WorkloadGenerator::generate_program(uint64_t sequence, int memory_size) {
+    // Mixed rather than added, so program n under seed s is unrelated to program
+    // n - 1 under seed s + 1.
+    uint64_t mixed_sequence = sequence;
+    Xoshiro256 rng(base_seed ^ splitmix64(mixed_sequence));
+    GeneratedProgram program;
+    uniform_int_distribution<> mem_dist(config.min_mem_per_proc, config.max_mem_per_proc);
+    int random_mem = mem_dist(rng);
+    program.memory_size = memory_size > 0 ? memory_size : static_cast<int>(pow(2, floor(log2(random_mem))));
+
+    uniform_int_distribution<> instr_dist(config.min_ins, config.max_ins);
+    int instruction_target = instr_dist(rng);
+    int potential_total = 0;
+    vector<string> declared_vars;
+    program.instructions = generate_instructions(rng, instruction_target, declared_vars, 0, potential_total, program.memory_size);
+    return program;
+}
+
+vector<Instruction> WorkloadGenerator::generate_instructions(Xoshiro256& rng, int num_instructions, vector<string>& declared_vars, int depth, int& potential_total_instructions, int memory_size) {
+    vector<Instruction> instructions;
+    uniform_int_distribution<> type_dist(0, 11);
+    // Block instructions stay above the variables and inside the process's memory.
+    int block_floor = MAX_VARIABLE_SLOTS * static_cast<int>(sizeof(uint16_t));
+    int block_words = (memory_size - block_floor) / 2;
+    auto random_block = [&](int words) {
+        uniform_int_distribution<> word_dist(0, block_words - words);
+        return block_floor + 2 * word_dist(rng);
+    };
+    for (int i = 0; i < num_instructions; ++i) {
+        if (potential_total_instructions >= config.max_ins) break;
+        int instruction_choice = type_dist(rng);
+        bool can_generate_for = (instruction_choice == 9 && depth < 3);
+        if (can_generate_for) {
+            uniform_int_distribution<uint16_t> repeat_dist(2, 10);
+            uint16_t repeats = repeat_dist(rng);
+            uniform_int_distribution<> inner_instr_count_dist(2, 5);
+            int inner_count = inner_instr_count_dist(rng);
+            int inner_potential_total = 0;
+            vector<Instruction> inner_instructions = generate_instructions(rng, inner_count, declared_vars, depth + 1, inner_potential_total, memory_size);
+            if (!inner_instructions.empty() && (potential_total_instructions + (inner_potential_total * repeats) < config.max_ins)) {
+                Instruction for_loop_instr;
+                for_loop_instr.type = InstructionType::FOR;
+                for_loop_instr.for_block = move(inner_instructions);
+                for_loop_instr.for_repeats = repeats;
+                instructions.push_back(move(for_loop_instr));
+                potential_total_instructions += (inner_potential_total * repeats);
+            } else {
+                instructions.push_back({InstructionType::PRINT, {}});
+                potential_total_instructions++;
+            }
+        } else {
+            if (instruction_choice == 5 && declared_vars.size() < 20) {
+                string new_var_name = "v" + to_string(declared_vars.size());
+                declared_vars.push_back(new_var_name);
+                uniform_int_distribution<uint16_t> val_dist(0, 1000);
+                instructions.push_back({InstructionType::DECLARE, {new_var_name, val_dist(rng)}});
+            } else if ((instruction_choice == 6 || instruction_choice == 7) && declared_vars.size() >= 2) {
+                uniform_int_distribution<size_t> var_idx_dist(0, declared_vars.size() - 1);
+                instructions.push_back({(instruction_choice == 6 ? InstructionType::ADD : InstructionType::SUBTRACT), {declared_vars[var_idx_dist(rng)], declared_vars[var_idx_dist(rng)], declared_vars[var_idx_dist(rng)]}});
+            } else if (instruction_choice >= 10 && block_words >= 8 && (instruction_choice == 10 || !declared_vars.empty())) {
+                uniform_int_distribution<> count_dist(8, min(128, block_words));
+                uint16_t words = static_cast<uint16_t>(count_dist(rng));
+                if (instruction_choice == 11) {
+                    uniform_int_distribution<size_t> var_idx_dist(0, declared_vars.size() - 1);
+                    instructions.push_back({InstructionType::SUM, {declared_vars[var_idx_dist(rng)], random_block(words), words}});
+                } else if (rng() % 2 == 0) {
+                    uniform_int_distribution<uint16_t> val_dist(0, 1000);
+                    instructions.push_back({InstructionType::MEMSET, {random_block(words), words, val_dist(rng)}});
+                } else {
+                    instructions.push_back({InstructionType::MEMCPY, {random_block(words), random_block(words), words}});
+                }
+            } else if (instruction_choice == 8) {
+                uniform_int_distribution<uint16_t> sleep_dist(5, 20);
+                instructions.push_back({InstructionType::SLEEP, {sleep_dist(rng)}});
+            } else {
+                instructions.push_back({InstructionType::PRINT, {}});
+            }
+            potential_total_instructions++;
+        }
+    }
+    return instructions;
+}
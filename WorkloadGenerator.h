@@ -0,0 +1,68 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include "Config.h"
+#include "Instruction.h"
+
+using namespace std;
+
+// xoshiro256** seeded through splitmix64. Satisfies UniformRandomBitGenerator so it
+// can drive the standard distributions.
+class Xoshiro256 {
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed);
+    result_type operator()();
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return numeric_limits<result_type>::max(); }
+
+private:
+    uint64_t state[4];
+};
+
+struct GeneratedProgram {
+    vector<Instruction> instructions;
+    int memory_size = 0;
+};
+
+// Pool of background threads that pre-generates random programs into a bounded
+// buffer. Program n is always generated from the seed and n alone, so the sequence
+// handed out by take() does not depend on which thread produced each program. Block
+// instructions only address memory inside the program's own memory size.
+class WorkloadGenerator {
+public:
+    WorkloadGenerator(const Config& cfg, uint64_t seed, int num_threads, size_t capacity);
+    ~WorkloadGenerator();
+
+    // With a memory size, the program is regenerated for that size if it was drawn
+    // for another one, so screen -s processes stay inside their memory.
+    GeneratedProgram take(int memory_size = 0);
+    void stop();
+
+private:
+    void worker_loop();
+    GeneratedProgram generate_program(uint64_t sequence, int memory_size = 0);
+    vector<Instruction> generate_instructions(Xoshiro256& rng, int num_instructions, vector<string>& declared_vars, int depth, int& potential_total_instructions, int memory_size);
+
+    Config config;
+    uint64_t base_seed;
+    size_t buffer_capacity;
+
+    map<uint64_t, GeneratedProgram> ready_programs;
+    uint64_t next_to_generate = 0;
+    uint64_t next_to_take = 0;
+    bool is_stopping = false;
+
+    vector<thread> generator_threads;
+    mutex buffer_mutex;
+    condition_variable space_available;
+    condition_variable program_ready;
+};
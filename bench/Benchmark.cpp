@@ -0,0 +1,517 @@
+// Microbenchmarks for the emulator's core engines. Built separately from the
+// emulator (see README) and prints one JSON document so results can be diffed
+// across changes.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include "Scheduler.h"
+#include "MemoryManager.h"
+#include "RunQueue.h"
+#include "Process.h"
+#include "ProgramLoader.h"
+
+using namespace std;
+
+struct BenchResult {
+    string name;
+    uint64_t ops = 0;
+    double ns_per_op = 0.0;
+    double ops_per_sec = 0.0;
+    double bytes_per_sec = 0.0;
+};
+
+// A benchmark body does its own setup and returns the nanoseconds spent in the
+// measured region, so setup cost never leaks into the result.
+using BenchBody = function<double()>;
+
+struct BenchCase {
+    string name;
+    uint64_t ops;
+    uint64_t bytes_per_op;
+    BenchBody body;
+};
+
+class Stopwatch {
+public:
+    Stopwatch() : start(chrono::steady_clock::now()) {}
+    double elapsed_ns() const { return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count(); }
+private:
+    chrono::steady_clock::time_point start;
+};
+
+// Results of reads are stored here so the compiler cannot drop the loop.
+static volatile uint64_t bench_sink = 0;
+
+static uint64_t next_random(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static shared_ptr<Process> make_bench_process(int pid, int memory_size, vector<Instruction> instructions = {}) {
+    auto process = make_shared<Process>(pid, "bench" + to_string(pid), make_shared<const CompiledProgram>(compile_program(instructions)), "");
+    process->memory_size = memory_size;
+    return process;
+}
+
+static void fault_in_all(MemoryManager& memory, const shared_ptr<Process>& process, int frame_size) {
+    for (int page = 0; page * frame_size < process->memory_size; ++page) memory.handle_page_fault(process, page);
+}
+
+// MEMORY ======================================================================
+
+static BenchBody translate_body(bool write, int working_set_pages, uint64_t ops) {
+    return [write, working_set_pages, ops]() {
+        const int frame_size = 256, memory_size = 65536;
+        MemoryManager memory(memory_size, frame_size);
+        auto process = make_bench_process(1, memory_size);
+        memory.create_virtual_memory_for_process(process);
+        fault_in_all(memory, process, frame_size);
+
+        vector<int> addresses(4096);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int& address : addresses) address = static_cast<int>(next_random(state) % (working_set_pages * frame_size / 2)) * 2;
+
+        uint64_t sink = 0;
+        Stopwatch watch;
+        for (uint64_t i = 0; i < ops; ++i) {
+            int address = addresses[i & (addresses.size() - 1)];
+            if (write) memory.write_memory(process, address, static_cast<uint16_t>(i));
+            else sink += memory.read_memory(process, address).value_or(0);
+        }
+        double ns = watch.elapsed_ns();
+        bench_sink = sink;
+        return ns;
+    };
+}
+
+// Every access misses the TLB and walks the page table: each process touches pages 0
+// and Tlb::SIZE, which share a TLB slot, alternately. Processes are picked at random,
+// so with many of them the page tables are spread over memory as in a busy system.
+static BenchBody page_table_walk_body(int num_processes, uint64_t ops) {
+    return [num_processes, ops]() {
+        const int frame_size = 64;
+        MemoryManager memory(num_processes * 2 * frame_size, frame_size);
+        vector<shared_ptr<Process>> processes;
+        for (int i = 0; i < num_processes; ++i) {
+            processes.push_back(make_bench_process(i + 1, (Tlb::SIZE + 1) * frame_size));
+            memory.create_virtual_memory_for_process(processes.back());
+            memory.handle_page_fault(processes.back(), 0);
+            memory.handle_page_fault(processes.back(), Tlb::SIZE);
+        }
+
+        vector<pair<int, int>> accesses(65536);
+        vector<bool> upper(num_processes, false);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (auto& access : accesses) {
+            int index = static_cast<int>(next_random(state) % num_processes);
+            upper[index] = !upper[index];
+            access = {index, upper[index] ? Tlb::SIZE * frame_size : 0};
+        }
+
+        uint64_t sink = 0;
+        Stopwatch watch;
+        for (uint64_t i = 0; i < ops; ++i) {
+            const auto& access = accesses[i & (accesses.size() - 1)];
+            sink += memory.read_memory(processes[access.first], access.second).value_or(0);
+        }
+        double ns = watch.elapsed_ns();
+        bench_sink = sink;
+        return ns;
+    };
+}
+
+// Cycles through a process four times larger than physical memory so every
+// access faults and, once memory is full, evicts the oldest page. Dirty runs
+// write each page after it is loaded, so every eviction goes to the backing store
+// and every later fault reads the page back.
+static BenchBody fault_cycle_body(bool dirty, int frame_size, uint64_t ops) {
+    return [dirty, frame_size, ops]() {
+        const int num_frames = 64;
+        MemoryManager memory(num_frames * frame_size, frame_size);
+        auto process = make_bench_process(1, num_frames * frame_size * 4);
+        memory.create_virtual_memory_for_process(process);
+        int num_pages = num_frames * 4;
+        for (int page = 0; page < num_pages; ++page) {
+            memory.handle_page_fault(process, page);
+            if (dirty) memory.write_memory(process, page * frame_size, 1);
+        }
+
+        Stopwatch watch;
+        for (uint64_t i = 0; i < ops; ++i) {
+            int page = static_cast<int>(i % num_pages);
+            memory.handle_page_fault(process, page);
+            if (dirty) memory.write_memory(process, page * frame_size, static_cast<uint16_t>(i));
+        }
+        return watch.elapsed_ns();
+    };
+}
+
+// Keeps physical memory full of 64-page processes and replaces them one at a time:
+// release a process, create another and fault in all of its pages. With many small
+// frames this is dominated by finding free frames and unlinking released ones.
+static BenchBody churn_body(int num_frames, uint64_t ops) {
+    return [num_frames, ops]() {
+        const int frame_size = 16, pages_per_process = 64;
+        const int resident = num_frames / pages_per_process;
+        MemoryManager memory(num_frames * frame_size, frame_size);
+        vector<shared_ptr<Process>> processes;
+        int next_pid = 1;
+        auto start_process = [&]() {
+            auto process = make_bench_process(next_pid++, pages_per_process * frame_size);
+            memory.create_virtual_memory_for_process(process);
+            fault_in_all(memory, process, frame_size);
+            return process;
+        };
+        for (int i = 0; i < resident; ++i) processes.push_back(start_process());
+
+        Stopwatch watch;
+        for (uint64_t i = 0; i < ops / pages_per_process; ++i) {
+            shared_ptr<Process>& slot = processes[(i * 7919) % resident];
+            memory.release_memory_for_process(slot);
+            slot = start_process();
+        }
+        return watch.elapsed_ns();
+    };
+}
+
+// A process four times larger than physical memory sends 90% of its accesses to
+// a hot set of a quarter of memory and the rest anywhere, a quarter of them
+// writes. Every access that faults loads the page and retries, so the result is
+// dominated by how often the policy evicts a hot page.
+static BenchBody replacement_body(ReplacementKind kind, uint64_t ops) {
+    return [kind, ops]() {
+        const int frame_size = 256, num_frames = 64, num_pages = num_frames * 4, hot_pages = num_frames / 4;
+        MemoryManager memory(num_frames * frame_size, frame_size, kind);
+        auto process = make_bench_process(1, num_pages * frame_size);
+        memory.create_virtual_memory_for_process(process);
+
+        vector<int> addresses(65536);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int& address : addresses) {
+            int page = (next_random(state) % 10 != 0) ? static_cast<int>(next_random(state) % hot_pages) : static_cast<int>(next_random(state) % num_pages);
+            address = page * frame_size + static_cast<int>(next_random(state) % (frame_size / 2)) * 2;
+        }
+
+        uint64_t sink = 0;
+        Stopwatch watch;
+        for (uint64_t i = 0; i < ops; ++i) {
+            int address = addresses[i & (addresses.size() - 1)];
+            bool write = (i & 3) == 0;
+            while (true) {
+                if (write ? memory.write_memory(process, address, static_cast<uint16_t>(i)) : memory.read_memory(process, address).has_value()) break;
+                memory.handle_page_fault(process, address / frame_size);
+            }
+            sink += address;
+        }
+        double ns = watch.elapsed_ns();
+        bench_sink = sink;
+        return ns;
+    };
+}
+
+// INTERPRETER =================================================================
+
+static Instruction make_instruction(InstructionType type, vector<Value> args) {
+    Instruction instruction;
+    instruction.type = type;
+    instruction.args = move(args);
+    return instruction;
+}
+
+// Words covered by each block instruction in the interpreter cases.
+const int BLOCK_WORDS = 128;
+
+static vector<Instruction> opcode_program(InstructionType type, uint64_t count) {
+    vector<Instruction> program;
+    program.push_back(make_instruction(InstructionType::DECLARE, {string("x"), uint16_t(1)}));
+    program.push_back(make_instruction(InstructionType::DECLARE, {string("y"), uint16_t(2)}));
+    Instruction body;
+    switch (type) {
+        case InstructionType::DECLARE: body = make_instruction(type, {string("x"), uint16_t(7)}); break;
+        case InstructionType::ADD: body = make_instruction(type, {string("x"), string("x"), string("y")}); break;
+        case InstructionType::SUBTRACT: body = make_instruction(type, {string("x"), string("x"), uint16_t(1)}); break;
+        case InstructionType::PRINT: body = make_instruction(type, {string("x = "), string("x")}); break;
+        case InstructionType::SLEEP: body = make_instruction(type, {uint16_t(0)}); break;
+        case InstructionType::READ: body = make_instruction(type, {string("x"), 512}); break;
+        case InstructionType::WRITE: body = make_instruction(type, {512, string("y")}); break;
+        case InstructionType::MEMSET: body = make_instruction(type, {512, uint16_t(BLOCK_WORDS), string("y")}); break;
+        case InstructionType::MEMCPY: body = make_instruction(type, {512, 768, uint16_t(BLOCK_WORDS)}); break;
+        case InstructionType::SUM: body = make_instruction(type, {string("x"), 512, uint16_t(BLOCK_WORDS)}); break;
+        case InstructionType::FOR: {
+            body = make_instruction(type, {});
+            body.for_block.push_back(make_instruction(InstructionType::ADD, {string("x"), string("x"), string("y")}));
+            body.for_repeats = 4;
+            count /= 4;
+            break;
+        }
+    }
+    program.insert(program.end(), count, body);
+    return program;
+}
+
+static string opcode_name(InstructionType type) {
+    switch (type) {
+        case InstructionType::PRINT: return "print";
+        case InstructionType::DECLARE: return "declare";
+        case InstructionType::ADD: return "add";
+        case InstructionType::SUBTRACT: return "subtract";
+        case InstructionType::SLEEP: return "sleep";
+        case InstructionType::FOR: return "for";
+        case InstructionType::READ: return "read";
+        case InstructionType::WRITE: return "write";
+        case InstructionType::MEMSET: return "memset";
+        case InstructionType::MEMCPY: return "memcpy";
+        case InstructionType::SUM: return "sum";
+    }
+    return "unknown";
+}
+
+// Runs a program of one repeated opcode with every page already resident, so the
+// result is pure interpreter cost. A FOR body counts as one op per instruction per pass.
+static BenchBody interpreter_body(InstructionType type, uint64_t ops) {
+    return [type, ops]() {
+        const int frame_size = 256, memory_size = 1024;
+        MemoryManager memory(memory_size * 4, frame_size);
+        auto process = make_bench_process(1, memory_size, opcode_program(type, ops));
+        memory.create_virtual_memory_for_process(process);
+        fault_in_all(memory, process, frame_size);
+
+        Stopwatch watch;
+        SliceResult result;
+        do {
+            result = process->run_slice(&memory, 0, MAX_SLICE_BATCH, 0);
+            if (result.reason == StopReason::PAGE_FAULT) memory.handle_page_fault(process, result.address / frame_size);
+        } while (result.reason != StopReason::FINISHED);
+        return watch.elapsed_ns();
+    };
+}
+
+// LOADER ======================================================================
+
+// A program source of the given number of lines cycling through every instruction,
+// with a two-level FOR every 64 lines.
+static string loader_source(uint64_t lines) {
+    static const char* const body[] = {
+        "DECLARE counter 10", "ADD counter counter 1", "SUBTRACT total counter 0x2", "WRITE 0x100 counter",
+        "READ total 0x100", "PRINT \"total is \" + total", "SLEEP 0", "MEMSET 0x200 16 counter",
+        "MEMCPY 0x240 0x200 16", "SUM total 0x240 16  # running total"};
+    string source;
+    for (uint64_t line = 0; line < lines; ++line) {
+        switch (line % 64) {
+            case 0: source += "FOR 4\n"; break;
+            case 1: source += "    FOR 2\n"; break;
+            case 5: source += "    END\n"; break;
+            case 8: source += "END\n"; break;
+            default: source += string(line % 64 < 8 ? "        " : "") + body[line % 10] + "\n"; break;
+        }
+    }
+    return source;
+}
+
+// Maps and parses a program file from disk; the file is written during setup.
+static BenchBody loader_body(uint64_t lines) {
+    return [lines]() {
+        const string path = "csopesy-bench-program.txt";
+        {
+            ofstream file(path, ios::binary | ios::trunc);
+            file << loader_source(lines);
+        }
+        Stopwatch watch;
+        ParseResult parsed = load_program_file(path);
+        double elapsed = watch.elapsed_ns();
+        if (!parsed.ok()) cerr << "loader: line " << parsed.error_line << ": " << parsed.error << "\n";
+        return elapsed;
+    };
+}
+
+// SCHEDULING ==================================================================
+
+// Every thread pushes then pops against one shared queue, so the result is the
+// cost of a push/pop pair under that much contention.
+static BenchBody run_queue_body(int num_threads, uint64_t ops) {
+    return [num_threads, ops]() {
+        RunQueue run_queue;
+        vector<vector<shared_ptr<Process>>> processes(num_threads);
+        for (int t = 0; t < num_threads; ++t) {
+            for (int i = 0; i < 8; ++i) processes[t].push_back(make_bench_process(t * 8 + i + 1, 0));
+        }
+        uint64_t per_thread = ops / num_threads;
+
+        atomic<int> ready{0};
+        atomic<bool> go{false};
+        vector<thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                ready++;
+                while (!go.load()) this_thread::yield();
+                for (uint64_t i = 0; i < per_thread; ++i) {
+                    run_queue.push(processes[t][i & 7]);
+                    while (!run_queue.pop()) {}
+                }
+            });
+        }
+        while (ready.load() < num_threads) this_thread::yield();
+        Stopwatch watch;
+        go = true;
+        for (auto& thread : threads) thread.join();
+        return watch.elapsed_ns();
+    };
+}
+
+// Drives the real dispatch path (dispatch, step, end of slice, requeue) in
+// lockstep mode. One op is one executed instruction.
+static BenchBody dispatch_body(int num_cpu, uint64_t ops) {
+    return [num_cpu, ops]() {
+        Config config;
+        config.num_cpu = num_cpu;
+        config.scheduler = SchedulingAlgorithm::RR;
+        config.quantum_cycles = 5;
+        config.batch_process_freq = 0;
+        config.max_overall_mem = 1 << 20;
+        config.mem_per_frame = 256;
+        config.archive_logs = false;
+        config.generator_threads = 1;
+        config.seed = 1;
+
+        const int num_processes = 64;
+        Scheduler scheduler;
+        scheduler.initialize(config, true);
+        scheduler.start_process_generation();
+        scheduler.stop_process_generation();
+        for (int i = 0; i < num_processes; ++i) {
+            vector<Instruction> program = opcode_program(InstructionType::ADD, ops / num_processes - 2);
+            scheduler.add_new_process("p" + to_string(i), 1024, move(program));
+        }
+
+        Stopwatch watch;
+        while (scheduler.get_registry().running_count() > 0) scheduler.run_tick();
+        double ns = watch.elapsed_ns();
+        scheduler.shutdown();
+        return ns;
+    };
+}
+
+// DRIVER ======================================================================
+
+static vector<BenchCase> all_benchmarks() {
+    vector<BenchCase> cases;
+    cases.push_back({"memory.translate.read", 2000000, 0, translate_body(false, 256, 2000000)});
+    cases.push_back({"memory.translate.write", 2000000, 0, translate_body(true, 256, 2000000)});
+    cases.push_back({"memory.translate.local.read", 2000000, 0, translate_body(false, 8, 2000000)});
+    cases.push_back({"memory.translate.local.write", 2000000, 0, translate_body(true, 8, 2000000)});
+    for (int processes : {1, 10000}) {
+        cases.push_back({"memory.translate.page_table/processes:" + to_string(processes), 2000000, 0, page_table_walk_body(processes, 2000000)});
+    }
+    for (int frames : {1024, 65536}) {
+        cases.push_back({"memory.churn/frames:" + to_string(frames), 64000, 0, churn_body(frames, 64000)});
+    }
+    for (ReplacementKind kind : {ReplacementKind::FIFO, ReplacementKind::CLOCK, ReplacementKind::SECOND_CHANCE, ReplacementKind::LRU, ReplacementKind::WSCLOCK}) {
+        cases.push_back({string("memory.replacement/policy:") + replacement_kind_name(kind), 200000, 0, replacement_body(kind, 200000)});
+    }
+    cases.push_back({"memory.fault.clean", 200000, 0, fault_cycle_body(false, 256, 200000)});
+    cases.push_back({"memory.fault.dirty", 50000, 0, fault_cycle_body(true, 256, 50000)});
+    for (int frame_size : {256, 4096}) {
+        cases.push_back({"memory.backing_store/frame:" + to_string(frame_size), 20000, static_cast<uint64_t>(frame_size) * 2,
+                         fault_cycle_body(true, frame_size, 20000)});
+    }
+    for (InstructionType type : {InstructionType::DECLARE, InstructionType::ADD, InstructionType::SUBTRACT, InstructionType::PRINT,
+                                 InstructionType::SLEEP, InstructionType::READ, InstructionType::WRITE, InstructionType::FOR}) {
+        cases.push_back({"interpreter." + opcode_name(type), 200000, 0, interpreter_body(type, 200000)});
+    }
+    for (InstructionType type : {InstructionType::MEMSET, InstructionType::MEMCPY, InstructionType::SUM}) {
+        cases.push_back({"interpreter." + opcode_name(type), 200000, BLOCK_WORDS * sizeof(uint16_t), interpreter_body(type, 200000)});
+    }
+    uint64_t loader_lines = 500000;
+    cases.push_back({"loader.parse_file", loader_lines, loader_source(loader_lines).size() / loader_lines, loader_body(loader_lines)});
+    for (int threads : {1, 2, 4, 8}) {
+        cases.push_back({"run_queue.push_pop/threads:" + to_string(threads), 400000, 0, run_queue_body(threads, 400000)});
+    }
+    for (int cpus : {1, 4}) {
+        cases.push_back({"scheduler.dispatch/cpus:" + to_string(cpus), 256000, 0, dispatch_body(cpus, 256000)});
+    }
+    return cases;
+}
+
+static BenchResult run_benchmark(const BenchCase& bench, int repeats) {
+    bench.body();  // warm-up
+    vector<double> samples;
+    for (int i = 0; i < repeats; ++i) samples.push_back(bench.body());
+    sort(samples.begin(), samples.end());
+    double median_ns = samples[samples.size() / 2];
+
+    BenchResult result;
+    result.name = bench.name;
+    result.ops = bench.ops;
+    result.ns_per_op = median_ns / bench.ops;
+    result.ops_per_sec = (median_ns > 0) ? bench.ops * 1e9 / median_ns : 0.0;
+    result.bytes_per_sec = result.ops_per_sec * bench.bytes_per_op;
+    return result;
+}
+
+static void write_json(ostream& out, const vector<BenchResult>& results, int repeats) {
+    out << fixed << setprecision(2);
+    out << "{\n";
+    out << "  \"suite\": \"csopesy-bench\",\n";
+    out << "  \"repeats\": " << repeats << ",\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops << ", \"ns_per_op\": " << r.ns_per_op
+            << ", \"ops_per_sec\": " << r.ops_per_sec;
+        if (r.bytes_per_sec > 0) out << ", \"bytes_per_sec\": " << r.bytes_per_sec;
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+int main(int argc, char* argv[]) {
+    string filter, output_path;
+    int repeats = 5;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--output" && i + 1 < argc) output_path = argv[++i];
+        else if (arg == "--repeats" && i + 1 < argc) repeats = max(1, atoi(argv[++i]));
+        else if (arg == "--list") {
+            for (const auto& bench : all_benchmarks()) cout << bench.name << "\n";
+            return 0;
+        } else {
+            cerr << "Usage: csopesy_bench [--filter <substring>] [--repeats <n>] [--output <file>] [--list]\n";
+            return 1;
+        }
+    }
+
+    // glibc skips locked instructions in mutexes until a second thread exists. The
+    // emulator always runs several, so make every benchmark pay the same price.
+    thread([] {}).join();
+
+    vector<BenchResult> results;
+    for (const auto& bench : all_benchmarks()) {
+        if (!filter.empty() && bench.name.find(filter) == string::npos) continue;
+        BenchResult result = run_benchmark(bench, repeats);
+        cerr << left << setw(36) << result.name << right << fixed << setprecision(1)
+             << setw(12) << result.ns_per_op << " ns/op" << setw(16) << setprecision(0) << result.ops_per_sec << " ops/s\n";
+        results.push_back(result);
+    }
+
+    if (output_path.empty()) {
+        write_json(cout, results, repeats);
+    } else {
+        ofstream out(output_path);
+        if (!out) { cerr << "Could not open " << output_path << "\n"; return 1; }
+        write_json(out, results, repeats);
+    }
+    return 0;
+}
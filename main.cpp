@@ -17,6 +17,8 @@
 #include <optional>
 #include "Scheduler.h"
 #include "MemoryManager.h"
+#include "ProgramLoader.h"
+#include "Platform.h"
 
 using namespace std;
 
@@ -30,23 +32,31 @@ using namespace std;
 // FUNCTION DECLARATIONS ===================================================================================================
 void print_header();
 void initialize(Scheduler& scheduler, Config& config, bool& initialized);
+bool load_config(const string& path, Config& config);
+bool handle_command(const string& input, Scheduler& scheduler, Config& config, bool& initialized);
+int run_headless(int argc, char* argv[]);
 void report_util(Scheduler& scheduler, const Config& config);
 void clear();
-void display_process_screen(shared_ptr<Process> process);
+void display_process_screen(Scheduler& scheduler, shared_ptr<Process> process);
 void list_screens(Scheduler& scheduler, const Config& config);
 void process_smi(Scheduler& scheduler);
-void vmstat(Scheduler& scheduler, const Config& config);
+void vmstat(Scheduler& scheduler);
+void latency(Scheduler& scheduler, const string& process_name);
+void print_latency_summary(ostream& out, Scheduler& scheduler);
 bool is_power_of_two(int n);
-vector<Instruction> parse_instructions_from_string(const string& raw_instructions, int& error_code);
 string get_timestamp_from_time_t(time_t time);
 
 // MAIN PROGRAM ============================================================================================================
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--headless") {
+        return run_headless(argc, argv);
+    }
+
     Scheduler scheduler;
     Config config;
     bool initialized = false;
 
-    system("cls");
+    clear_console();
     print_header();
 
     string input;
@@ -58,138 +68,337 @@ int main() {
              break;
         }
 
-        stringstream ss(input);
-        string command;
-        ss >> command;
+        if (!handle_command(input, scheduler, config, initialized)) break;
+    }
 
-        if (!initialized && command != "initialize" && command != "exit") {
-            cout << "Please enter the command 'initialize' before using any other command.\n";
-            continue;
-        }
+    cout << "Shutting down scheduler and worker threads..." << endl;
+    scheduler.shutdown();
+    cout << "Shutdown complete. Exiting." << endl;
+    return 0;
+}
 
-        if (command == "initialize") {
-            string junk;
-            if (ss >> junk) {
-                cout << "Initialize command takes no arguments. Please try again.\n";
-            } else {
-                initialize(scheduler, config, initialized);
-            }
+// Runs one CLI command. Returns false when the command asks the program to exit.
+bool handle_command(const string& input, Scheduler& scheduler, Config& config, bool& initialized) {
+    stringstream ss(input);
+    string command;
+    ss >> command;
+
+    if (!initialized && command != "initialize" && command != "exit") {
+        cout << "Please enter the command 'initialize' before using any other command.\n";
+        return true;
+    }
+
+    if (command == "initialize") {
+        string junk;
+        if (ss >> junk) {
+            cout << "Initialize command takes no arguments. Please try again.\n";
+        } else {
+            initialize(scheduler, config, initialized);
         }
-        else if (command == "screen") {
-            string opt;
-            if (!(ss >> opt)) {
-                cout << "Please specify a screen option (e.g., -s, -c, -r, -ls).\n";
-                continue;
+    }
+    else if (command == "screen") {
+        string opt;
+        if (!(ss >> opt)) {
+            cout << "Please specify a screen option (e.g., -s, -c, -f, -r, -n, -ls).\n";
+            return true;
+        }
+        if (opt == "-s" || opt == "-c" || opt == "-f") {
+            string name, size_str;
+            if (!(ss >> name >> size_str)) {
+                if (opt == "-f") cout << "Usage: screen -f <name> <size> <file>\n";
+                else cout << "Usage: screen " << opt << " <name> <size> [deadline]" << (opt == "-c" ? " \"<instructions>\"" : "") << "\n";
+                return true;
             }
-            if (opt == "-s" || opt == "-c") {
-                string name, size_str;
-                if (!(ss >> name >> size_str)) {
-                    cout << "Usage: screen " << opt << " <name> <size>" << (opt == "-c" ? " \"<instructions>\"" : "") << "\n";
-                    continue;
-                }
-                int mem_size;
-                try { mem_size = stoi(size_str); } catch(...) { cout << "Invalid memory size specified.\n"; continue; }
-
-                if (mem_size < 64 || mem_size > 65536 || !is_power_of_two(mem_size)) {
-                    cout << "Invalid memory allocation. Size must be a power of 2 between 64 and 65536.\n";
-                } else if (scheduler.find_process(name)) {
-                    cout << "Screen '" << name << "' already exists.\n";
-                } else {
-                    if (opt == "-s") {
-                        scheduler.add_new_process(name, mem_size, nullopt);
-                        cout << "Screen '" << name << "' created with " << mem_size << " bytes of memory.\n";
-                    } else { // -c
-                        string instruction_str;
-                        getline(ss, instruction_str);
-                        size_t first = instruction_str.find_first_not_of(" \t\"");
-                        size_t last = instruction_str.find_last_not_of(" \t\"");
-                        if (string::npos != first && string::npos != last) {
-                            instruction_str = instruction_str.substr(first, (last - first + 1));
-                        } else { instruction_str = ""; }
-                        if (instruction_str.empty()) { cout << "Usage: screen -c <name> <size> \"<instructions>\"\n"; continue; }
-                        int error_code = 0;
-                        vector<Instruction> instructions = parse_instructions_from_string(instruction_str, error_code);
-                        if (error_code == 1) {
-                            cout << "Invalid command: Instruction count must be between 1 and 50.\n";
-                        } else {
-                            scheduler.add_new_process(name, mem_size, instructions);
-                            cout << "Screen '" << name << "' created with custom instructions.\n";
-                        }
+            int mem_size;
+            try { mem_size = stoi(size_str); } catch(...) { cout << "Invalid memory size specified.\n"; return true; }
+            int deadline_ticks = -1;
+            ss >> ws;
+            if (opt != "-f" && isdigit(ss.peek()) && !(ss >> deadline_ticks)) { cout << "Invalid deadline specified.\n"; return true; }
+
+            if (mem_size < 64 || mem_size > 65536 || !is_power_of_two(mem_size)) {
+                cout << "Invalid memory allocation. Size must be a power of 2 between 64 and 65536.\n";
+            } else if (scheduler.find_process(name)) {
+                cout << "Screen '" << name << "' already exists.\n";
+            } else {
+                if (opt == "-s") {
+                    if (!scheduler.add_new_process(name, mem_size, nullopt, deadline_ticks)) cout << "Screen '" << name << "' already exists.\n";
+                    else cout << "Screen '" << name << "' created with " << mem_size << " bytes of memory.\n";
+                } else if (opt == "-c") {
+                    string instruction_str;
+                    getline(ss, instruction_str);
+                    instruction_str.erase(instruction_str.find_last_not_of(" \t\r") + 1);
+                    if (instruction_str.size() >= 2 && instruction_str.front() == '"' && instruction_str.back() == '"') {
+                        instruction_str = instruction_str.substr(1, instruction_str.size() - 2);
                     }
-                }
-            }
-            // THIS DOESNT SHOW LOGS WHEN FINISHED (mod below)
-            // else if (opt == "-r") {
-            //     string name;
-            //     if (!(ss >> name)) { cout << "Usage: screen -r <process_name>\n"; continue; }
-            //     auto process = scheduler.find_process(name);
-            //     if (process) {
-            //         if (process->mem_violation.occurred) {
-            //             tm localTime;
-            //             localtime_s(&localTime, &process->mem_violation.timestamp);
-            //             char buffer[10];
-            //             strftime(buffer, sizeof(buffer), "%H:%M:%S", &localTime);
-            //             cout << "Process <" << name << "> shut down due to memory access violation error at " << buffer << ". ";
-            //             cout << "0x" << hex << process->mem_violation.address << dec << " invalid.\n";
-            //         } else if (process->is_finished.load()) {
-            //             cout << "Process <" << name << "> has finished execution.\n";
-            //         } else {
-            //             display_process_screen(process);
-            //         }
-            //     } else {
-            //         cout << "Process <" << name << "> not found.\n";
-            //     }
-            // }
-            else if (opt == "-r") {
-                string name;
-                if (!(ss >> name)) {
-                    cout << "Usage: screen -r <process_name>\n";
-                    continue;
-                }
-                
-                auto process = scheduler.find_process(name);
-                if (process) {
-                    if (process->mem_violation.occurred) {
-                        tm localTime;
-                        localtime_s(&localTime, &process->mem_violation.timestamp);
-                        char buffer[10];
-                        strftime(buffer, sizeof(buffer), "%H:%M:%S", &localTime);
-                        
-                        cout << "Process <" << name << "> shut down due to memory access violation error at " << buffer << ". ";
-                        cout << "0x" << hex << process->mem_violation.address << dec << " invalid.\n";
+                    if (instruction_str.find_first_not_of(" \t") == string::npos) { cout << "Usage: screen -c <name> <size> [deadline] \"<instructions>\"\n"; return true; }
+                    ParseResult parsed = parse_program(instruction_str);
+                    if (!parsed.ok()) {
+                        cout << "Invalid command: " << parsed.error << ".\n";
+                    } else if (parsed.statement_count == 0 || parsed.statement_count > 50) {
+                        cout << "Invalid command: Instruction count must be between 1 and 50.\n";
                     } else {
-                        display_process_screen(process);
+                        if (!scheduler.add_new_process(name, mem_size, parsed.instructions, deadline_ticks)) cout << "Screen '" << name << "' already exists.\n";
+                        else cout << "Screen '" << name << "' created with custom instructions.\n";
                     }
+                } else { // -f
+                    string path;
+                    getline(ss, path);
+                    path.erase(path.find_last_not_of(" \t\r") + 1);
+                    if (path.size() >= 2 && path.front() == '"' && path.back() == '"') path = path.substr(1, path.size() - 2);
+                    if (path.empty()) { cout << "Usage: screen -f <name> <size> <file>\n"; return true; }
+                    ParseResult parsed = load_program_file(path);
+                    if (!parsed.ok()) {
+                        if (parsed.error_line > 0) cout << path << ", line " << parsed.error_line << ": " << parsed.error << ".\n";
+                        else cout << "Error: " << parsed.error << ".\n";
+                    } else if (parsed.statement_count == 0) {
+                        cout << path << " has no instructions.\n";
+                    } else {
+                        if (!scheduler.add_new_process(name, mem_size, parsed.instructions, deadline_ticks)) cout << "Screen '" << name << "' already exists.\n";
+                        else cout << "Screen '" << name << "' created with " << parsed.statement_count << " instructions from " << path << ".\n";
+                    }
+                }
+            }
+        }
+        // THIS DOESNT SHOW LOGS WHEN FINISHED (mod below)
+        // else if (opt == "-r") {
+        //     string name;
+        //     if (!(ss >> name)) { cout << "Usage: screen -r <process_name>\n"; return true; }
+        //     auto process = scheduler.find_process(name);
+        //     if (process) {
+        //         if (process->mem_violation.occurred) {
+        //             tm localTime;
+        //             localtime_s(&localTime, &process->mem_violation.timestamp);
+        //             char buffer[10];
+        //             strftime(buffer, sizeof(buffer), "%H:%M:%S", &localTime);
+        //             cout << "Process <" << name << "> shut down due to memory access violation error at " << buffer << ". ";
+        //             cout << "0x" << hex << process->mem_violation.address << dec << " invalid.\n";
+        //         } else if (process->is_finished.load()) {
+        //             cout << "Process <" << name << "> has finished execution.\n";
+        //         } else {
+        //             display_process_screen(process);
+        //         }
+        //     } else {
+        //         cout << "Process <" << name << "> not found.\n";
+        //     }
+        // }
+        else if (opt == "-r") {
+            string name;
+            if (!(ss >> name)) {
+                cout << "Usage: screen -r <process_name>\n";
+                return true;
+            }
+            
+            auto process = scheduler.find_process(name);
+            if (process) {
+                if (process->mem_violation.occurred) {
+                    tm localTime;
+                    localtime_s(&localTime, &process->mem_violation.timestamp);
+                    char buffer[10];
+                    strftime(buffer, sizeof(buffer), "%H:%M:%S", &localTime);
+                    
+                    cout << "Process <" << name << "> shut down due to memory access violation error at " << buffer << ". ";
+                    cout << "0x" << hex << process->mem_violation.address << dec << " invalid.\n";
                 } else {
-                    cout << "Process <" << name << "> not found.\n";
+                    display_process_screen(scheduler, process);
                 }
+            } else {
+                cout << "Process <" << name << "> not found.\n";
             }
-            else if (opt == "-ls") {
-                string junk;
-                if (ss >> junk) { cout << "Screen -ls does not take any additional arguments.\n"; } 
-                else { list_screens(scheduler, config); }
+        }
+        else if (opt == "-n") {
+            string count_str, junk;
+            int count = 0;
+            if (!(ss >> count_str) || (ss >> junk)) { cout << "Usage: screen -n <count>\n"; return true; }
+            try { count = stoi(count_str); } catch(...) { count = 0; }
+            if (count <= 0) { cout << "Invalid process count specified.\n"; return true; }
+            scheduler.spawn_random_processes(count);
+            cout << "Spawned " << count << " random process" << (count == 1 ? "" : "es") << ".\n";
+        }
+        else if (opt == "-ls") {
+            string junk;
+            if (ss >> junk) { cout << "Screen -ls does not take any additional arguments.\n"; } 
+            else { list_screens(scheduler, config); }
+        }
+        else { cout << "Unknown screen command: " << opt << ". Use -s, -c, -f, -r, -n, or -ls.\n"; }
+    }
+    else if (command == "scheduler-start") {
+        scheduler.start_process_generation();
+        cout << "Starting process generation...\n";
+    }
+    else if (command == "scheduler-stop") {
+        scheduler.stop_process_generation();
+        cout << "Stopping process generation...\n";
+    }
+    else if (command == "report-util") { report_util(scheduler, config); }
+    else if (command == "process-smi") { process_smi(scheduler); }
+    else if (command == "vmstat") { vmstat(scheduler); }
+    else if (command == "latency") {
+        string name;
+        ss >> name;
+        latency(scheduler, name);
+    }
+    else if (command == "clear") { clear(); }
+    else if (command == "exit") { return false; }
+    else if (!command.empty()) { cout << "Unknown command: " << command << ". Please try again." << endl; }
+    return true;
+}
+
+// HEADLESS SCENARIO RUNNER ================================================================================================
+struct ScriptCommand {
+    int tick;
+    string command;
+};
+
+static void write_latency_json(ostream& out, const char* name, const LatencyHistogram& histogram, bool last) {
+    out << "    \"" << name << "\": {\"samples\": " << histogram.count() << ", \"mean\": " << histogram.mean()
+        << ", \"p50\": " << histogram.percentile(50) << ", \"p90\": " << histogram.percentile(90)
+        << ", \"p99\": " << histogram.percentile(99) << ", \"max\": " << histogram.maximum() << "}" << (last ? "\n" : ",\n");
+}
+
+// Runs a scenario without the interactive console: the scheduler runs in lockstep on
+// this thread (see Scheduler::run_tick), script commands fire at their tick, and a
+// JSON summary is written when the stop condition is met.
+int run_headless(int argc, char* argv[]) {
+    const char* usage = "Usage: csopesy_emulator --headless [--config <file>] [--script <file>] [--seed <n>]"
+                        " [--stop ticks:<n>|processes:<n>|finished] [--output <file>]\n";
+    string config_path = "config.txt", script_path, output_path, stop_condition = "finished";
+    uint64_t seed = 1;
+    for (int i = 2; i < argc; ++i) {
+        string arg = argv[i];
+        if (i + 1 >= argc) { cerr << usage; return 1; }
+        string value = argv[++i];
+        if (arg == "--config") config_path = value;
+        else if (arg == "--script") script_path = value;
+        else if (arg == "--output") output_path = value;
+        else if (arg == "--stop") stop_condition = value;
+        else if (arg == "--seed") { try { seed = stoull(value); } catch(...) { cerr << usage; return 1; } }
+        else { cerr << usage; return 1; }
+    }
+
+    long long stop_limit = 0;
+    string stop_kind = stop_condition.substr(0, stop_condition.find(':'));
+    if (stop_kind == "ticks" || stop_kind == "processes") {
+        try { stop_limit = stoll(stop_condition.substr(stop_condition.find(':') + 1)); } catch(...) { cerr << usage; return 1; }
+    } else if (stop_kind != "finished") {
+        cerr << usage; return 1;
+    }
+
+    Config config;
+    if (!load_config(config_path, config)) { cerr << "Error: Could not open " << config_path << "\n"; return 1; }
+    config.seed = seed;
+
+    vector<ScriptCommand> script;
+    if (!script_path.empty()) {
+        ifstream script_file(script_path);
+        if (!script_file.is_open()) { cerr << "Error: Could not open " << script_path << "\n"; return 1; }
+        string line;
+        while (getline(script_file, line)) {
+            line.erase(0, line.find_first_not_of(" \t\r"));
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            if (line.empty() || line[0] == '#') continue;
+            ScriptCommand entry{0, line};
+            if (line[0] == '@') {
+                size_t space = line.find(' ');
+                try { entry.tick = stoi(line.substr(1, space - 1)); } catch(...) { cerr << "Invalid script line: " << line << "\n"; return 1; }
+                entry.command = (space == string::npos) ? "" : line.substr(space + 1);
             }
-            else { cout << "Unknown screen command: " << opt << ". Use -s, -c, -r, or -ls.\n"; }
+            script.push_back(entry);
         }
-        else if (command == "scheduler-start") {
-            scheduler.start_process_generation();
-            cout << "Starting process generation...\n";
+        stable_sort(script.begin(), script.end(), [](const ScriptCommand& a, const ScriptCommand& b) { return a.tick < b.tick; });
+    }
+
+    Scheduler scheduler;
+    scheduler.initialize(config, true);
+    bool initialized = true;
+    const ProcessRegistry& registry = scheduler.get_registry();
+
+    streambuf* console = cout.rdbuf(cerr.rdbuf());
+    auto started = chrono::steady_clock::now();
+    size_t next_command = 0;
+    bool exit_requested = false;
+    while (!exit_requested) {
+        int tick = scheduler.get_current_tick();
+        while (next_command < script.size() && (script[next_command].tick <= tick || !scheduler.is_running())) {
+            const string& line = script[next_command++].command;
+            stringstream line_ss(line);
+            string command, opt;
+            line_ss >> command >> opt;
+            if (command == "initialize") continue;
+            if (command == "clear" || (command == "screen" && opt == "-r")) {
+                cerr << "Skipping interactive command in headless mode: " << line << "\n";
+                continue;
+            }
+            if (!handle_command(line, scheduler, config, initialized)) { exit_requested = true; break; }
         }
-        else if (command == "scheduler-stop") {
-            scheduler.stop_process_generation();
-            cout << "Stopping process generation...\n";
+        bool script_done = next_command == script.size();
+        if (exit_requested) break;
+        if (stop_kind == "ticks" && tick >= stop_limit) break;
+        if (stop_kind == "processes" && static_cast<long long>(registry.retired_count()) >= stop_limit) break;
+        if (stop_kind == "finished" && script_done && !scheduler.is_generating() && registry.running_count() == 0) break;
+        if (!scheduler.is_running() && script_done) {
+            cerr << "Scheduler was never started; stopping at tick " << tick << ".\n";
+            break;
         }
-        else if (command == "report-util") { report_util(scheduler, config); }
-        else if (command == "process-smi") { process_smi(scheduler); }
-        else if (command == "vmstat") { vmstat(scheduler, config); }
-        else if (command == "clear") { clear(); }
-        else if (command == "exit") { break; }
-        else if (!command.empty()) { cout << "Unknown command: " << command << ". Please try again." << endl; }
+        scheduler.run_tick();
     }
+    double wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    cout.rdbuf(console);
 
-    cout << "Shutting down scheduler and worker threads..." << endl;
+    uint64_t digest = 1469598103934665603ULL;
+    auto mix = [&digest](uint64_t value) {
+        for (int i = 0; i < 8; ++i) { digest ^= (value >> (i * 8)) & 0xFF; digest *= 1099511628211ULL; }
+    };
+    for (const auto& proc : scheduler.get_all_processes()) {
+        mix(proc->id);
+        mix(static_cast<uint64_t>(proc->finished_tick.load()));
+        mix(proc->get_executed_count());
+    }
+
+    MetricsSnapshot metrics = scheduler.get_metrics();
+    int ticks = metrics.current_tick;
+    uint64_t instructions = metrics.active_ticks;
+    uint64_t total_ticks = metrics.total_ticks;
+    const LatencyStats& latency_stats = scheduler.get_latency_stats();
+    size_t retired = metrics.finished_processes + metrics.faulted_processes;
+
+    ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path);
+        if (!output_file.is_open()) { cerr << "Error: Could not open " << output_path << "\n"; return 1; }
+    }
+    ostream& out = output_path.empty() ? cout : output_file;
+    out << fixed << setprecision(4);
+    out << "{\n";
+    out << "  \"seed\": " << seed << ",\n";
+    out << "  \"stop_condition\": \"" << stop_condition << "\",\n";
+    out << "  \"ticks\": " << ticks << ",\n";
+    out << "  \"wall_seconds\": " << wall_seconds << ",\n";
+    out << "  \"processes_admitted\": " << metrics.running_processes + retired << ",\n";
+    out << "  \"processes_finished\": " << metrics.finished_processes << ",\n";
+    out << "  \"memory_violations\": " << metrics.faulted_processes << ",\n";
+    out << "  \"program_images\": " << metrics.program_images << ",\n";
+    out << "  \"throughput_per_1000_ticks\": " << (ticks > 0 ? retired * 1000.0 / ticks : 0.0) << ",\n";
+    out << "  \"instructions_executed\": " << instructions << ",\n";
+    out << "  \"instructions_per_sec\": " << (wall_seconds > 0 ? instructions / wall_seconds : 0.0) << ",\n";
+    out << "  \"cpu_utilization\": " << (total_ticks > 0 ? static_cast<double>(instructions) / total_ticks : 0.0) << ",\n";
+    out << "  \"dispatches\": " << metrics.dispatches << ",\n";
+    out << "  \"preemptions\": " << metrics.preemptions << ",\n";
+    out << "  \"requeues\": " << metrics.requeues << ",\n";
+    out << "  \"tlb_hits\": " << metrics.tlb_hits << ",\n";
+    out << "  \"tlb_misses\": " << metrics.tlb_misses << ",\n";
+    out << "  \"page_ins\": " << metrics.memory.page_ins << ",\n";
+    out << "  \"page_outs\": " << metrics.memory.page_outs << ",\n";
+    out << "  \"page_writes\": " << metrics.memory.page_writes << ",\n";
+    out << "  \"replacement_policy\": \"" << metrics.memory.replacement_policy << "\",\n";
+    out << "  \"faults_per_1000_instructions\": " << (instructions > 0 ? metrics.memory.page_ins * 1000.0 / instructions : 0.0) << ",\n";
+    out << "  \"latency_ticks\": {\n";
+    write_latency_json(out, "wait", latency_stats.wait.ticks, false);
+    write_latency_json(out, "turnaround", latency_stats.turnaround.ticks, false);
+    write_latency_json(out, "response", latency_stats.response.ticks, true);
+    out << "  },\n";
+    out << "  \"schedule_digest\": \"" << hex << setw(16) << setfill('0') << digest << dec << setfill(' ') << "\"\n";
+    out << "}\n";
     scheduler.shutdown();
-    cout << "Shutdown complete. Exiting." << endl;
     return 0;
 }
 
@@ -202,15 +411,28 @@ string get_timestamp_from_time_t(time_t time) {
     return string(buffer);
 }
 
-void display_process_screen(shared_ptr<Process> process) {
+// Shows one page of the log at a time. The view follows the newest lines until the
+// user pages back with prev/first; next past the end or last follows them again.
+void display_process_screen(Scheduler& scheduler, shared_ptr<Process> process) {
+    const size_t page_lines = 20;
     string sub_command;
+    bool follow_tail = true;
+    size_t first_line = 0;
     while(true) {
-        system("cls");
-        lock_guard<mutex> lock(process->data_mutex);
+        clear_console();
+        size_t line_count = scheduler.get_log_line_count(process);
+        if (follow_tail || first_line >= line_count) {
+            follow_tail = true;
+            first_line = (line_count > page_lines) ? line_count - page_lines : 0;
+        }
+        size_t last_line = min(line_count, first_line + page_lines);
         cout << "Process name: " << process->name << "\n";
         cout << "ID: " << process->id << "\n";
-        cout << "Logs:\n";
-        for(const auto& log : process->logs) {
+        cout << "Logs (lines " << (line_count > 0 ? first_line + 1 : 0) << "-" << last_line << " of " << line_count << "):\n";
+        if (uint64_t dropped = process->get_dropped_log_count()) {
+            cout << "(" << dropped << " older log lines dropped)\n";
+        }
+        for(const auto& log : scheduler.get_process_logs(process, first_line, page_lines)) {
             cout << log << "\n";
         }
         cout << "\nCurrent instruction line: " << process->get_executed_count() << "\n";
@@ -219,8 +441,12 @@ void display_process_screen(shared_ptr<Process> process) {
         cout << CYAN << "> " << RESET;
         getline(cin, sub_command);
         if (sub_command == "exit") { clear(); break; }
+        else if (sub_command == "prev") { follow_tail = false; first_line = (first_line > page_lines) ? first_line - page_lines : 0; }
+        else if (sub_command == "next") { follow_tail = false; first_line += page_lines; }
+        else if (sub_command == "first") { follow_tail = false; first_line = 0; }
+        else if (sub_command == "last") { follow_tail = true; }
         else if (!sub_command.empty()){
-            cout << "Unknown command inside process screen. Type 'exit' to return.\n";
+            cout << "Unknown command inside process screen. Use prev, next, first, last or exit.\n";
             this_thread::sleep_for(chrono::seconds(2));
         }
     }
@@ -229,7 +455,7 @@ void display_process_screen(shared_ptr<Process> process) {
 void list_screens(Scheduler& scheduler, const Config& config) {
     auto running = scheduler.get_running_processes();
     auto finished = scheduler.get_finished_processes();
-    int cores_used = scheduler.get_cores_used();
+    int cores_used = scheduler.get_metrics().cores_used;
     float utilization = (config.num_cpu > 0) ? (static_cast<float>(cores_used) / config.num_cpu) * 100 : 0;
     cout << "----------------------------------------\n";
     cout << "CPU utilization: " << fixed << setprecision(2) << utilization << "%\n";
@@ -240,7 +466,9 @@ void list_screens(Scheduler& scheduler, const Config& config) {
         cout << left << setw(12) << proc->name 
              << " (" << get_timestamp_from_time_t(proc->creation_time_t) << ")"
              << "  Core: " << (proc->core_assigned == -1 ? "wait" : to_string(proc->core_assigned))
-             << "   " << proc->get_executed_count() << " / " << proc->get_total_instructions() << "\n";
+             << "   " << proc->get_executed_count() << " / " << proc->get_total_instructions();
+        if (config.scheduler == SchedulingAlgorithm::MLFQ) cout << "   Level: " << proc->priority_level.load();
+        cout << "\n";
     }
     cout << "\n" BRIGHTGREEN << "Finished processes:\n" << RESET;
     for (const auto& proc : finished) {
@@ -286,12 +514,26 @@ void print_header() {
 }
 
 void initialize(Scheduler& scheduler, Config& config, bool& initialized) {
-    ifstream file("config.txt");
-    if (!file.is_open()) { cout << "Error: Could not open config.txt\n"; return; }
+    if (!load_config("config.txt", config)) { cout << "Error: Could not open config.txt\n"; return; }
+    scheduler.initialize(config);
+    initialized = true;
+    cout << "\nSystem initialized successfully with config from config.txt\n\n";
+}
+
+bool load_config(const string& path, Config& config) {
+    ifstream file(path);
+    if (!file.is_open()) return false;
     string key, value_str;
     while (file >> key) {
         if (key == "num-cpu") file >> config.num_cpu;
-        else if (key == "scheduler") { file >> value_str; config.scheduler = (value_str == "\"rr\"" || value_str == "rr") ? SchedulingAlgorithm::RR : SchedulingAlgorithm::FCFS; }
+        else if (key == "scheduler") {
+            file >> value_str;
+            value_str.erase(remove(value_str.begin(), value_str.end(), '"'), value_str.end());
+            if (value_str == "rr") config.scheduler = SchedulingAlgorithm::RR;
+            else if (value_str == "mlfq") config.scheduler = SchedulingAlgorithm::MLFQ;
+            else if (value_str == "edf") config.scheduler = SchedulingAlgorithm::EDF;
+            else config.scheduler = SchedulingAlgorithm::FCFS;
+        }
         else if (key == "quantum-cycles") file >> config.quantum_cycles;
         else if (key == "batch-process-freq") file >> config.batch_process_freq;
         else if (key == "min-ins") file >> config.min_ins;
@@ -301,11 +543,32 @@ void initialize(Scheduler& scheduler, Config& config, bool& initialized) {
         else if (key == "mem-per-frame") file >> config.mem_per_frame;
         else if (key == "min-mem-per-proc") file >> config.min_mem_per_proc;
         else if (key == "max-mem-per-proc") file >> config.max_mem_per_proc;
+        else if (key == "page-replacement") {
+            file >> value_str;
+            value_str.erase(remove(value_str.begin(), value_str.end(), '"'), value_str.end());
+            if (!parse_replacement_kind(value_str, config.page_replacement)) config.page_replacement = ReplacementKind::FIFO;
+        }
+        else if (key == "virtual-clock") file >> config.virtual_clock;
+        else if (key == "archive-logs") file >> config.archive_logs;
+        else if (key == "log-capacity") file >> config.log_capacity;
+        else if (key == "batch-process-size") file >> config.batch_process_size;
+        else if (key == "generator-threads") file >> config.generator_threads;
+        else if (key == "pager-threads") file >> config.pager_threads;
+        else if (key == "seed") file >> config.seed;
+        else if (key == "mlfq-levels") file >> config.mlfq_levels;
+        else if (key == "mlfq-boost-period") file >> config.mlfq_boost_period;
+        else if (key == "mlfq-quanta") {
+            file >> value_str;
+            stringstream quanta_ss(value_str);
+            string quantum_str;
+            config.mlfq_quanta.clear();
+            while (getline(quanta_ss, quantum_str, ',')) {
+                try { config.mlfq_quanta.push_back(stoi(quantum_str)); } catch(...) {}
+            }
+        }
     }
     file.close();
-    scheduler.initialize(config);
-    initialized = true;
-    cout << "\nSystem initialized successfully with config from config.txt\n\n";
+    return true;
 }
 
 void report_util(Scheduler& scheduler, const Config& config) {
@@ -317,7 +580,7 @@ void report_util(Scheduler& scheduler, const Config& config) {
 
     auto running = scheduler.get_running_processes();
     auto finished = scheduler.get_finished_processes();
-    int cores_used = scheduler.get_cores_used();
+    int cores_used = scheduler.get_metrics().cores_used;
     float utilization = (config.num_cpu > 0) ? (static_cast<float>(cores_used) / config.num_cpu) * 100 : 0;
 
     report_file << "CPU utilization: " << fixed << setprecision(2) << utilization << "%\n";
@@ -339,62 +602,50 @@ void report_util(Scheduler& scheduler, const Config& config) {
              << "  Finished   "
              << proc->get_total_instructions() << " / " << proc->get_total_instructions() << "\n";
     }
+
+    int current_tick = scheduler.get_current_tick();
+    int deadline_processes = 0;
+    vector<shared_ptr<Process>> missed;
+    for (const auto& proc : scheduler.get_all_processes()) {
+        if (proc->absolute_deadline == NO_DEADLINE) continue;
+        deadline_processes++;
+        if (proc->missed_deadline(current_tick)) missed.push_back(proc);
+    }
+    report_file << "\nMissed deadlines: " << missed.size() << " / " << deadline_processes << "\n";
+    for (const auto& proc : missed) {
+        int finish = proc->finished_tick.load();
+        report_file << left << setw(12) << proc->name
+             << "  Deadline: tick " << proc->absolute_deadline
+             << (finish == -1 ? "   Still running at tick " + to_string(current_tick) : "   Finished at tick " + to_string(finish)) << "\n";
+    }
+
+    report_file << "\n";
+    print_latency_summary(report_file, scheduler);
     report_file.close();
     cout << "Report generated at csopesy-log.txt!\n";
 }
 
-void clear() { system("cls"); print_header(); }
+void clear() { clear_console(); print_header(); }
 
 bool is_power_of_two(int n) { if (n <= 0) return false; return (n & (n - 1)) == 0; }
 
-vector<Instruction> parse_instructions_from_string(const string& raw_instructions, int& error_code) {
-    vector<Instruction> parsed;
-    stringstream inst_stream(raw_instructions);
-    string segment;
-    while(getline(inst_stream, segment, ';')) {
-        segment.erase(0, segment.find_first_not_of(" \t\n\r"));
-        segment.erase(segment.find_last_not_of(" \t\n\r") + 1);
-        if (segment.empty()) continue;
-        stringstream single_inst_ss(segment);
-        string type_str;
-        single_inst_ss >> type_str;
-        Instruction inst;
-        if (type_str == "DECLARE") inst.type = InstructionType::DECLARE;
-        else if (type_str == "ADD") inst.type = InstructionType::ADD;
-        else if (type_str == "SUBTRACT") inst.type = InstructionType::SUBTRACT;
-        else if (type_str == "READ") inst.type = InstructionType::READ;
-        else if (type_str == "WRITE") inst.type = InstructionType::WRITE;
-        else if (type_str == "PRINT") inst.type = InstructionType::PRINT;
-        else continue;
-        string arg;
-        while(single_inst_ss >> arg) {
-            if (arg.rfind("0x", 0) == 0) {
-                try { inst.args.push_back(stoi(arg, nullptr, 16)); } catch(...) {}
-            } else if (all_of(arg.begin(), arg.end(), ::isdigit)) {
-                try { inst.args.push_back(static_cast<uint16_t>(stoi(arg))); } catch(...) {}
-            } else {
-                inst.args.push_back(arg);
-            }
-        }
-        parsed.push_back(inst);
-    }
-    if (parsed.empty() || parsed.size() > 50) { error_code = 1; }
-    return parsed;
-}
-
 void process_smi(Scheduler& scheduler) {
-    MemoryManager* mem_manager = scheduler.get_memory_manager();
-    if (!mem_manager) { cout << "Memory Manager not initialized." << endl; return; }
+    MetricsSnapshot metrics = scheduler.get_metrics();
     cout << "+-----------------------------------------------------------------------------+\n";
     cout << "| Process Status and Memory Information                                       |\n";
     cout << "+-----------------------------------------------------------------------------+\n";
-    int total_mem = mem_manager->get_total_memory();
-    int used_mem = mem_manager->get_used_memory();
+    int total_mem = metrics.memory.total_memory;
+    int used_mem = metrics.memory.used_memory;
     float util = (total_mem > 0) ? (static_cast<float>(used_mem) / total_mem) * 100 : 0;
     stringstream mem_ss;
     mem_ss << "| Memory Usage: " << used_mem << "B / " << total_mem << "B (" << fixed << setprecision(2) << util << "%)";
     string mem_str = mem_ss.str();
     cout << mem_str << string(78 - mem_str.length(), ' ') << "|\n";
+    stringstream count_ss;
+    count_ss << "| Processes: " << metrics.running_processes << " running, " << metrics.finished_processes
+             << " finished, " << metrics.faulted_processes << " MEM_FAULT";
+    string count_str = count_ss.str();
+    cout << count_str << string(78 - count_str.length(), ' ') << "|\n";
     cout << "+-----------------------+---------+------------------+------------------------+\n";
     cout << "| Process Name          | PID     | Virt. Memory (B) | Status                 |\n";
     cout << "+-----------------------+---------+------------------+------------------------+\n";
@@ -408,29 +659,86 @@ void process_smi(Scheduler& scheduler) {
     cout << "+-----------------------+---------+------------------+------------------------+\n";
 }
 
-void vmstat(Scheduler& scheduler, const Config& config) {
-    MemoryManager* mem_manager = scheduler.get_memory_manager();
-    if (!mem_manager) { cout << "Error: Memory Manager not initialized." << endl; return; }
-    long long total_mem_kb = config.max_overall_mem / 1024;
-    long long used_mem_kb = mem_manager->get_used_memory() / 1024;
-    long long active_mem_kb = mem_manager->get_active_memory() / 1024; 
+void vmstat(Scheduler& scheduler) {
+    MetricsSnapshot metrics = scheduler.get_metrics();
+    long long total_mem_kb = metrics.memory.total_memory / 1024;
+    long long used_mem_kb = metrics.memory.used_memory / 1024;
+    long long active_mem_kb = metrics.memory.active_memory / 1024;
     long long free_mem_kb = total_mem_kb - used_mem_kb;
-    uint64_t total_ticks = scheduler.get_total_ticks();
-    uint64_t active_ticks = scheduler.get_active_ticks();
-    uint64_t idle_ticks = (total_ticks > active_ticks) ? total_ticks - active_ticks : 0;
-    const PagingStats& stats = mem_manager->get_paging_stats();
-    uint64_t paged_in = stats.page_ins.load();
-    uint64_t paged_out = stats.page_outs.load();
     cout << "\n--- System Virtual Memory Statistics ---\n";
     cout << setw(12) << right << total_mem_kb << " K total memory\n";
     cout << setw(12) << right << used_mem_kb << " K used memory\n";
     cout << setw(12) << right << active_mem_kb << " K active memory\n"; 
     cout << setw(12) << right << free_mem_kb << " K free memory\n";
+    cout << setw(12) << right << metrics.program_images << " program images\n";
     cout << "----------------------------------------\n";
-    cout << setw(12) << right << total_ticks << " total cpu ticks\n";
-    cout << setw(12) << right << active_ticks << " active cpu ticks\n";
-    cout << setw(12) << right << idle_ticks << " idle cpu ticks\n";
+    cout << setw(12) << right << metrics.total_ticks << " total cpu ticks\n";
+    cout << setw(12) << right << metrics.active_ticks << " active cpu ticks\n";
+    cout << setw(12) << right << metrics.idle_ticks << " idle cpu ticks\n";
+    cout << setw(12) << right << metrics.dispatches << " dispatches\n";
+    cout << setw(12) << right << metrics.preemptions << " preemptions\n";
+    cout << setw(12) << right << metrics.requeues << " requeues\n";
+    cout << setw(12) << right << metrics.idle_wakeups << " idle wakeups\n";
+    cout << setw(12) << right << metrics.steals << " work steals\n";
+    cout << setw(12) << right << fixed << setprecision(1) << metrics.dispatches_per_sec << " dispatches/sec\n";
+    cout << "----------------------------------------\n";
+    uint64_t translations = metrics.tlb_hits + metrics.tlb_misses;
+    cout << setw(12) << right << metrics.tlb_hits << " TLB hits\n";
+    cout << setw(12) << right << metrics.tlb_misses << " TLB misses\n";
+    cout << setw(12) << right << fixed << setprecision(1) << (translations > 0 ? metrics.tlb_hits * 100.0 / translations : 0.0) << " % TLB hit rate\n";
+    cout << setw(12) << right << metrics.memory.page_ins << " pages paged in\n";
+    cout << setw(12) << right << metrics.memory.page_outs << " pages paged out\n";
+    cout << setw(12) << right << metrics.memory.page_writes << " pages written back\n";
+    cout << setw(12) << right << fixed << setprecision(2) << (metrics.active_ticks > 0 ? metrics.memory.page_ins * 1000.0 / metrics.active_ticks : 0.0)
+         << " page faults per 1000 instructions (" << metrics.memory.replacement_policy << ")\n";
+    cout << setw(12) << right << metrics.faults_serviced << " page faults serviced\n";
+    cout << setw(12) << right << fixed << setprecision(1) << metrics.fault_service_mean_us << " us avg fault service time\n";
+    cout << setw(12) << right << metrics.fault_service_p99_us << " us p99 fault service time\n";
+    cout << setw(12) << right << metrics.pager_queue_depth << " pager queue depth (max "
+         << metrics.pager_max_queue_depth << ")\n\n";
+}
+
+void print_latency_summary(ostream& out, Scheduler& scheduler) {
+    const LatencyStats& stats = scheduler.get_latency_stats();
+    const pair<const char*, const LatencyMetric*> metrics[] = {
+        {"wait", &stats.wait}, {"turnaround", &stats.turnaround}, {"response", &stats.response}};
+    out << "--- Process Latency Statistics ---\n";
+    out << left << setw(18) << "" << right << setw(10) << "samples" << setw(12) << "mean"
+        << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << "\n";
+    for (const auto& metric : metrics) {
+        const LatencyHistogram& ticks = metric.second->ticks;
+        out << left << setw(18) << string(metric.first) + " (ticks)" << right << setw(10) << ticks.count()
+            << setw(12) << fixed << setprecision(2) << ticks.mean()
+            << setw(10) << ticks.percentile(50) << setw(10) << ticks.percentile(90)
+            << setw(10) << ticks.percentile(99) << setw(10) << ticks.maximum() << "\n";
+        const LatencyHistogram& wall_us = metric.second->wall_us;
+        out << left << setw(18) << string(metric.first) + " (ms)" << right << setw(10) << wall_us.count()
+            << setw(12) << fixed << setprecision(2) << wall_us.mean() / 1000.0
+            << setw(10) << setprecision(1) << wall_us.percentile(50) / 1000.0 << setw(10) << wall_us.percentile(90) / 1000.0
+            << setw(10) << wall_us.percentile(99) / 1000.0 << setw(10) << wall_us.maximum() / 1000.0 << "\n";
+    }
+}
+
+void latency(Scheduler& scheduler, const string& process_name) {
+    if (process_name.empty()) {
+        cout << "\n";
+        print_latency_summary(cout, scheduler);
+        cout << "\n";
+        return;
+    }
+    auto process = scheduler.find_process(process_name);
+    if (!process) { cout << "Process <" << process_name << "> not found.\n"; return; }
+    const char* state_names[NUM_PROCESS_STATES] = {"ready", "running", "fault-blocked", "sleeping", "finished"};
+    int current_tick = scheduler.get_current_tick();
+    cout << "\n--- Latency for " << process->name << " (" << state_names[static_cast<int>(process->get_state())] << ") ---\n";
+    for (int i = 0; i < static_cast<int>(ProcessState::FINISHED); ++i) {
+        ElapsedTime elapsed = process->get_time_in_state(static_cast<ProcessState>(i), current_tick);
+        cout << setw(12) << right << elapsed.ticks << " ticks " << setw(12) << fixed << setprecision(1) << elapsed.wall_ms
+             << " ms  " << state_names[i] << "\n";
+    }
+    ElapsedTime response = process->get_response_time();
+    ElapsedTime turnaround = process->get_turnaround_time();
     cout << "----------------------------------------\n";
-    cout << setw(12) << right << paged_in << " pages paged in\n";
-    cout << setw(12) << right << paged_out << " pages paged out\n\n";
+    cout << setw(12) << right << response.ticks << " ticks " << setw(12) << response.wall_ms << " ms  response\n";
+    cout << setw(12) << right << turnaround.ticks << " ticks " << setw(12) << turnaround.wall_ms << " ms  turnaround\n\n";
 }
\ No newline at end of file
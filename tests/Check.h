@@ -0,0 +1,14 @@
+#pragma once
+#include <iostream>
+
+// Minimal assertion support for the test programs: a failed CHECK is reported
+// and counted, and the program's exit status is the number of failures.
+inline int check_failures = 0;
+
+#define CHECK(condition)                                                                         \
+    do {                                                                                         \
+        if (!(condition)) {                                                                      \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition "\n";      \
+            check_failures++;                                                                    \
+        }                                                                                        \
+    } while (0)
@@ -0,0 +1,47 @@
+#include "Check.h"
+#include "ProgramLoader.h"
+
+using namespace std;
+
+static bool same_instructions(const vector<Instruction>& a, const vector<Instruction>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].type != b[i].type || a[i].args != b[i].args || a[i].for_repeats != b[i].for_repeats) return false;
+        if (!same_instructions(a[i].for_block, b[i].for_block)) return false;
+    }
+    return true;
+}
+
+static bool parses_like(string_view source, string_view expected) {
+    ParseResult parsed = parse_program(source);
+    ParseResult reference = parse_program(expected);
+    if (!parsed.ok()) cerr << "'" << source << "': " << parsed.error << "\n";
+    return parsed.ok() && reference.ok() && same_instructions(parsed.instructions, reference.instructions);
+}
+
+// screen -c text is often quoted for the shell, so quotes inside it arrive as \",
+// and PRINT is often written as a call.
+static void test_screen_c_forms() {
+    CHECK(parses_like("PRINT(\\\"Result: \\\" + varC)", "PRINT \"Result: \" + varC"));
+    CHECK(parses_like("PRINT \\\"x\\\" + v", "PRINT \"x\" + v"));
+    CHECK(parses_like("PRINT(\"x\"+v)", "PRINT \"x\" + v"));
+    CHECK(parses_like("PRINT()", "PRINT"));
+    CHECK(parses_like("DECLARE(x, 5); ADD(x, x, 1)", "DECLARE x 5; ADD x x 1"));
+
+    ParseResult spec = parse_program("DECLARE varA 10; DECLARE varB 5; ADD varA varA varB; WRITE 0x500 varA; "
+                                     "READ varC 0x500; PRINT(\\\"Result: \\\" + varC)");
+    CHECK(spec.ok());
+    CHECK(spec.statement_count == 6);
+}
+
+static void test_malformed() {
+    CHECK(!parse_program("PRINT(\"x\"").ok());
+    CHECK(!parse_program("PRINT \\\"x").ok());
+    CHECK(!parse_program("ADD(x, x)").ok());
+}
+
+int main() {
+    test_screen_c_forms();
+    test_malformed();
+    return check_failures;
+}
@@ -0,0 +1,80 @@
+#include <thread>
+#include <chrono>
+#include <functional>
+#include "Check.h"
+#include "Scheduler.h"
+#include "ProgramLoader.h"
+
+using namespace std;
+
+static vector<Instruction> busy_program() {
+    return parse_program("DECLARE x 0\nFOR 60000\nFOR 60000\nADD x x 1\nEND\nEND\n").instructions;
+}
+
+// Never touches process memory, so it cannot page-fault and give up its core.
+static vector<Instruction> print_program() {
+    return parse_program("FOR 60000\nFOR 60000\nPRINT \"tick\"\nEND\nEND\n").instructions;
+}
+
+static bool wait_until(const function<bool()>& condition) {
+    for (int i = 0; i < 500 && !condition(); ++i) this_thread::sleep_for(chrono::milliseconds(10));
+    return condition();
+}
+
+// A process with an earlier deadline must preempt the running one after its
+// current instruction, however long the running process's slice could be.
+static void test_edf_preemption_delay() {
+    CHECK(slice_batch_limit(SchedulingAlgorithm::EDF) == 1);
+
+    Config config;
+    config.num_cpu = 1;
+    config.scheduler = SchedulingAlgorithm::EDF;
+    config.batch_process_freq = 0;
+    config.archive_logs = false;
+    Scheduler scheduler;
+    scheduler.initialize(config);
+    scheduler.start_process_generation();
+
+    scheduler.add_new_process("background", 1024, busy_program());
+    shared_ptr<Process> background = scheduler.find_process("background");
+    CHECK(wait_until([&] { return background->get_executed_count() > 10000; }));
+
+    scheduler.add_new_process("urgent", 1024, print_program(), 1000);
+    size_t executed_at_arrival = background->get_executed_count();
+    shared_ptr<Process> urgent = scheduler.find_process("urgent");
+    CHECK(wait_until([&] { return urgent->get_executed_count() > 10000; }));
+    CHECK(background->get_executed_count() - executed_at_arrival <= 1);
+
+    scheduler.shutdown();
+}
+
+// Without the log archive a retired process keeps only its newest log records, and
+// its TLB is freed along with the rest of its execution state.
+static void test_retired_process_state() {
+    Config config;
+    config.num_cpu = 1;
+    config.batch_process_freq = 0;
+    config.archive_logs = false;
+    Scheduler scheduler;
+    scheduler.initialize(config, true);
+    scheduler.start_process_generation();
+
+    scheduler.add_new_process("printer", 1024, parse_program("FOR 100\nPRINT \"tick\"\nEND\n").instructions);
+    shared_ptr<Process> printer = scheduler.find_process("printer");
+    for (int tick = 0; tick < 10000 && !printer->is_finished.load(); ++tick) scheduler.run_tick();
+
+    CHECK(printer->is_finished.load());
+    CHECK(scheduler.get_log_line_count(printer) == RETIRED_LOG_CAPACITY);
+    CHECK(printer->get_dropped_log_count() == 100 - RETIRED_LOG_CAPACITY);
+    CHECK(printer->tlb == nullptr);
+    vector<LogRecord> records = printer->get_log_records();
+    CHECK(!records.empty() && records.back().tick > records.front().tick);
+
+    scheduler.shutdown();
+}
+
+int main() {
+    test_edf_preemption_delay();
+    test_retired_process_state();
+    return check_failures;
+}
@@ -0,0 +1,73 @@
+#include <variant>
+#include "Check.h"
+#include "WorkloadGenerator.h"
+
+using namespace std;
+
+// Counts the block instructions in a program, nested loops included, and clears
+// in_bounds if any of them reaches outside [0, memory_size).
+static int count_blocks(const vector<Instruction>& instructions, int memory_size, bool& in_bounds) {
+    int blocks = 0;
+    for (const auto& instruction : instructions) {
+        if (instruction.type == InstructionType::FOR) {
+            blocks += count_blocks(instruction.for_block, memory_size, in_bounds);
+            continue;
+        }
+        vector<int> addresses;
+        int words = 0;
+        if (instruction.type == InstructionType::MEMSET) {
+            addresses = {get<int>(instruction.args[0])};
+            words = get<uint16_t>(instruction.args[1]);
+        } else if (instruction.type == InstructionType::MEMCPY) {
+            addresses = {get<int>(instruction.args[0]), get<int>(instruction.args[1])};
+            words = get<uint16_t>(instruction.args[2]);
+        } else if (instruction.type == InstructionType::SUM) {
+            addresses = {get<int>(instruction.args[1])};
+            words = get<uint16_t>(instruction.args[2]);
+        } else {
+            continue;
+        }
+        blocks++;
+        for (int address : addresses) {
+            if (address < 0 || address + 2 * words > memory_size) in_bounds = false;
+        }
+    }
+    return blocks;
+}
+
+// screen -s may ask for less memory than min-mem-per-proc; the program it gets must
+// still fit, as must the generator's own programs at their drawn sizes.
+static void test_blocks_stay_inside_memory() {
+    Config config;
+    config.min_mem_per_proc = 1024;
+    config.max_mem_per_proc = 4096;
+    WorkloadGenerator generator(config, 7, 2, 8);
+
+    for (int memory_size : {64, 128, 256, 1024}) {
+        int blocks = 0;
+        bool in_bounds = true;
+        for (int i = 0; i < 50; ++i) {
+            GeneratedProgram program = generator.take(memory_size);
+            CHECK(program.memory_size == memory_size);
+            blocks += count_blocks(program.instructions, memory_size, in_bounds);
+        }
+        CHECK(in_bounds);
+        if (memory_size >= 128) CHECK(blocks > 0);
+        else CHECK(blocks == 0);
+    }
+
+    int blocks = 0;
+    bool in_bounds = true;
+    for (int i = 0; i < 50; ++i) {
+        GeneratedProgram program = generator.take();
+        CHECK(program.memory_size >= 1024 && program.memory_size <= 4096);
+        blocks += count_blocks(program.instructions, program.memory_size, in_bounds);
+    }
+    CHECK(in_bounds);
+    CHECK(blocks > 0);
+}
+
+int main() {
+    test_blocks_stay_inside_memory();
+    return check_failures;
+}